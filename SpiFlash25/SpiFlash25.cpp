@@ -21,6 +21,7 @@
  */
 
 #include "SpiFlash25.h"
+#include "profiler.h"
 
 SpiFlash25::SpiFlash25(PinName mosi, PinName miso, PinName sclk, PinName cs, PinName W, PinName HOLD, int page_size, int mem_size)
 :   _spi(mosi, miso, sclk),
@@ -54,6 +55,8 @@ void SpiFlash25::frequency(int hz) {
 }
 
 bool SpiFlash25::read(int addr, int len, char* data) {
+    PROFILE_SCOPE(PROFILE_FLASH_READ);
+
     if (addr + len > _mem_size) {
         return false;
     }
@@ -76,6 +79,8 @@ bool SpiFlash25::read(int addr, int len, char* data) {
 }
 
 bool SpiFlash25::write(int addr, int len, const char* data) {
+    PROFILE_SCOPE(PROFILE_FLASH_WRITE);
+
     if (addr + len > _mem_size) {
         return false;
     }
@@ -131,6 +136,8 @@ char SpiFlash25::read_status() {
 }
 
 void SpiFlash25::clear_sector(int addr) {
+    PROFILE_SCOPE(PROFILE_FLASH_ERASE);
+
     enable_write();
 
     _cs.write(0);
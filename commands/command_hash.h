@@ -0,0 +1,17 @@
+// Generated by tools/command_hash.py from command_list.h, do not edit.
+// Slot i holds 1 + the index of the command hashing to i, 0 if none.
+
+#define COMMAND_HASH_SEED 0x00000327UL
+#define COMMAND_HASH_BITS 7
+#define COMMAND_HASH_SLOTS 128
+
+static const uint8_t command_slots[COMMAND_HASH_SLOTS] = {
+     0,  0, 23, 18,  0,  0, 31,  0, 15,  0,  0,  0,  0,  0, 37,  0,
+     0,  7, 13,  0,  0,  0, 32,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  9,  0,  0,  3,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0, 29,  8,  0,  0, 19, 16, 41,  0,  0, 27, 39, 35,  0,  0,
+     0,  0,  0, 11, 17,  0,  6, 34,  0,  0, 25, 22,  0, 24,  0,  0,
+    36, 40,  0,  0,  0,  0, 26,  0,  0,  0,  0, 12, 38,  0,  0,  0,
+     5,  1,  0,  0,  0,  0,  0, 20,  0,  0, 14,  0,  0, 30,  0,  0,
+     0,  0,  0,  0, 21,  0, 10,  0,  4, 33,  0,  0,  0, 28,  0,  0,
+};
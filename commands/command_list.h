@@ -0,0 +1,85 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+/**
+ * Shell commands, one entry per command:
+ *
+ *   SHELL_COMMAND(name, help, usage, handler)
+ *       handler(argc, argv) parses its own arguments
+ *
+ *   SHELL_SETTING(name, help)
+ *       shows or sets the field of the same name in field_list.h
+ *
+ * Run tools/command_hash.py after changing names, it regenerates the
+ * dispatch table in command_hash.h. Target specific commands go last so
+ * the table is valid for every target.
+ */
+
+SHELL_COMMAND(help, "display help", "[command]", help_func)
+SHELL_COMMAND(reset, "reset command", "", reset_func)
+SHELL_COMMAND(run, "run command", "", run_func)
+SHELL_SETTING(deveui, "deveui command")
+SHELL_SETTING(appeui, "appeui command")
+SHELL_SETTING(appkey, "appkey command")
+SHELL_SETTING(retries, "ack retries setting")
+SHELL_SETTING(datarate, "datarate setting")
+SHELL_COMMAND(class, "device class setting", "A or C", device_class_func)
+SHELL_SETTING(adr, "adr enabled")
+SHELL_SETTING(port, "Application port")
+SHELL_SETTING(txinterval, "Tx interval in ms")
+SHELL_SETTING(sampleinterval, "Sensor sample interval in ms")
+SHELL_SETTING(dutycycle, "Duty Cycle enabled")
+SHELL_COMMAND(joinbackoff, "Join retry backoff", "min max in ms", join_backoff_func)
+SHELL_COMMAND(txbackoff, "Failed uplink retry backoff", "min max in ms", tx_backoff_func)
+SHELL_SETTING(jitter, "Randomized percent of retry backoff")
+SHELL_COMMAND(status, "application status", "", status_func)
+SHELL_COMMAND(send, "send queued readings now", "", send_func)
+SHELL_COMMAND(queue, "uplink queue status", "clear", queue_func)
+SHELL_COMMAND(console, "console buffer statistics", "clear", console_func)
+SHELL_COMMAND(power, "time per power state", "", power_func)
+SHELL_COMMAND(events, "event queue statistics", "clear", events_func)
+SHELL_COMMAND(mem, "stack, heap and buffer usage", "", mem_func)
+SHELL_COMMAND(prof, "execution time probes", "clear", prof_func)
+SHELL_COMMAND(tracelevel, "active trace levels", "none|error|warn|info|debug", trace_level_func)
+SHELL_COMMAND(get, "show configuration fields", "name [name ...]", get_func)
+SHELL_COMMAND(set, "set configuration fields", "name=value [name=value ...]", set_func)
+SHELL_COMMAND(dump, "show all configuration fields", "[protected|network|app]", dump_func)
+SHELL_COMMAND(savep, "save provisioning", "", savep_func)
+SHELL_COMMAND(save, "save changed settings", "[all]", save_func)
+SHELL_COMMAND(provision, "binary provisioning mode", "", provision_func)
+#if defined (TARGET_MTS_MDOT_F411RE)
+SHELL_COMMAND(ufbench, "user file append benchmark", "[records] [record size]", user_file_bench_func)
+SHELL_COMMAND(rx, "receive a user file by YMODEM", "name", rx_func)
+SHELL_COMMAND(ls, "list files", "", ls_func)
+SHELL_COMMAND(df, "filesystem usage", "", df_func)
+SHELL_COMMAND(cat, "print a file", "name", cat_func)
+SHELL_COMMAND(hexdump, "print a file in hex", "name", hexdump_func)
+SHELL_COMMAND(rm, "delete a file", "name", rm_func)
+SHELL_COMMAND(fsck, "check and repair the filesystem", "", fsck_func)
+SHELL_COMMAND(bench, "flash and filesystem benchmark", "", bench_func)
+#endif /* TARGET_MTS_MDOT_F411RE */
@@ -28,51 +28,105 @@
 
 #include "commands.h"
 #include "lorawan_types.h"
+#include "shell_mailbox.h"
+#include "console_rx.h"
+#include "console_tx.h"
+#include "deferred_trace.h"
+#include "trace_helper.h"
+#include "profiler.h"
+#include "memory_monitor.h"
+#include "queue_monitor.h"
+#include "platform/mbed_stats.h"
+#include "provisioning.h"
+#include "ymodem.h"
+#include "shell_parser.h"
+#include "config_fields.h"
+#include "uplink_queue.h"
 
-extern Serial pc;
 extern DeviceConfig_t device_config;
 extern ConfigManager config_mng;
-
-bool exit_cmd_mode = false;
+extern ShellMailbox shell_mailbox;
+extern ConsoleRx console_rx;
+extern ConsoleTx console_tx;
+extern QueueMonitor ev_monitor;
+extern UplinkQueue uplink_queue;
+extern volatile bool command_mode;
+#if MBED_CONF_APP_MAINTENANCE_QUEUE
+extern QueueMonitor maintenance_monitor;
+#endif
 
 static char prompt[] = "$ ";
 static char ok_str[] = "\r\nOK\r\n";
 static char error_str[] = "\r\nerror\r\n";
 static char invalid_args_str[] = "\r\ninvalid args\r\n";
+static char command_mode_str[] = "\r\nonly in boot command mode\r\n";
+
+// binary provisioning gives up after this long without a request
+static const uint32_t provision_timeout = 10000;
+
+static Provisioning provisioning(console_rx, console_tx, config_mng, device_config);
 
-tinysh_cmd_t reset_cmd = { 0, "reset", "reset command", "", reset_func, 0, 0, 0 };
-tinysh_cmd_t run_cmd = { 0, "run", "run command", "", run_func, 0, 0, 0 };
-tinysh_cmd_t deveui_cmd = { 0, "deveui", "deveui command", "", deveui_func, 0, 0, 0 };
-tinysh_cmd_t appeui_cmd = { 0, "appeui", "appeui command", "", appeui_func, 0, 0, 0 };
-tinysh_cmd_t appkey_cmd = { 0, "appkey", "appkey command", "", appkey_func, 0, 0, 0 };
-tinysh_cmd_t savep_cmd = { 0, "savep", "save provisioning", "", savep_func, 0, 0, 0 };
-tinysh_cmd_t save_cmd = { 0, "save", "save settings", "", save_func, 0, 0, 0 };
-tinysh_cmd_t ack_retries_cmd = { 0, "retries", "ack retries setting", "0:disable,1-8", ack_retries_func, 0, 0, 0 };
-tinysh_cmd_t datarate_cmd = { 0, "datarate", "datarate setting", "0-15", datarate_func, 0, 0, 0 };
-tinysh_cmd_t device_class_cmd = { 0, "class", "device class setting", "A or C", device_class_func, 0, 0, 0 };
-tinysh_cmd_t adr_cmd = { 0, "adr", "adr enabled", "0:disabled, 1:enabled", adr_func, 0, 0, 0 };
-tinysh_cmd_t duty_cycle_cmd = { 0, "dutycycle", "Duty Cycle enabled", "0:disabled, 1:enabled", duty_cycle_func, 0, 0, 0 };
-tinysh_cmd_t tx_interval_cmd = { 0, "txinterval", "Tx interval", "Timeout in ms", tx_interval_func, 0, 0, 0 };
-tinysh_cmd_t app_port_cmd = { 0, "port", "Application port", "0-255", app_port_func, 0, 0, 0 };
+/**
+ * Commands that hold the file system or the console for long must not run
+ * beside the stack
+ */
+static bool require_command_mode() {
+    if (!command_mode) {
+        printf(command_mode_str);
+        return false;
+    }
+    return true;
+}
 
 void reset_func(int argc, char **argv) {
     HAL_NVIC_SystemReset();
 }
 
-void run_func(int argc, char **argv) {
-    exit_cmd_mode = true;
+/**
+ * Runs command on the application thread, which owns the stack state
+ */
+static bool call_app(uint8_t command, shell_response& response, const uint8_t* data = NULL, uint8_t length = 0) {
+    shell_request request;
+
+    request.Command = command;
+    request.Length = length;
+    if (length > 0) {
+        memcpy(request.Data, data, length);
+    }
+
+    return shell_mailbox.Call(request, response) && response.Status == 0;
 }
 
-int read_hex_str(const char* input, uint8_t* val, size_t length) {
-    unsigned char tmp = 0;
-    for (size_t i = 0, j = 0; i < length; ++i, j+=2) {
-        if (sscanf(input+j, "%2hhx", &tmp)) {
-            val[i] = tmp;
-        } else {
-            return -1;
-        }
+MBED_STATIC_ASSERT(3 + FIELD_MAX_SIZE <= MAILBOX_DATA_SIZE, "a field value doesn't fit a request");
+
+/**
+ * Have the application thread copy value into device_config at offset and
+ * mark section unsaved, the stack reads the configuration on that thread
+ */
+static bool write_config(uint16_t offset, const void* value, uint8_t length, uint8_t section) {
+    uint8_t data[MAILBOX_DATA_SIZE];
+    shell_response response;
+
+    data[0] = offset & 0xff;
+    data[1] = offset >> 8;
+    data[2] = section;
+    memcpy(data + 3, value, length);
+
+    return call_app(ShellMailbox::CONFIG_WRITE, response, data, 3 + length);
+}
+
+static bool store_field(const config_field& field, const uint8_t* value, uint8_t element = FIELD_ALL) {
+    return write_config(field_offset(field, element), value, field_size(field, element), field.Section);
+}
+
+void run_func(int argc, char **argv) {
+    shell_response response;
+
+    if (call_app(ShellMailbox::RUN, response)) {
+        printf(ok_str);
+    } else {
+        printf(error_str);
     }
-    return 0;
 }
 
 void print_hex_str(const uint8_t* val, size_t length) {
@@ -83,198 +137,962 @@ void print_hex_str(const uint8_t* val, size_t length) {
     printf("\r\n");
 }
 
-void deveui_func(int argc, char **argv) {
+void device_class_func(int argc, char **argv) {
+    static const char* const names[] = { "A", "C" };
+    static const uint8_t classes[] = { CLASS_A, CLASS_C };
+
     if (argc == 1) {
-        print_hex_str(device_config.provisioning.DeviceEUI, 8);
-        printf("\r\n");
-    } else if (argc == 2 && (strlen(argv[1]) == 16)) {
-        read_hex_str(argv[1], device_config.provisioning.DeviceEUI, 8);
+        printf("\r\n%s\r\n", device_config.settings.Class == CLASS_A ? "A" : "C");
+        return;
+    }
+
+    int choice = argc == 2 ? parse_choice(argv[1], names, sizeof(classes)) : -1;
+    if (choice < 0) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    if (write_config(offsetof(DeviceConfig_t, settings.Class), &classes[choice], 1, SECTION_NETWORK)) {
         printf(ok_str);
     } else {
-        printf(invalid_args_str);
+        printf(error_str);
     }
 }
 
-void appeui_func(int argc, char **argv) {
+/**
+ * Min and max are adjacent in ApplicationSettings_t, offset is the min
+ */
+static void backoff_func(int argc, char **argv, uint16_t offset) {
+    const uint32_t* delays = (const uint32_t*) ((const uint8_t*) &device_config + offset);
+
     if (argc == 1) {
-        print_hex_str(device_config.settings.AppEUI, 8);
-        printf("\r\n");
-    } else if (argc == 2 && (strlen(argv[1]) == 16)) {
-        read_hex_str(argv[1], device_config.settings.AppEUI, 8);
+        printf("\r\n%lu %lu\r\n", delays[0], delays[1]);
+    } else if (argc == 3) {
+        uint32_t values[2];
+        if (parse_uint(argv[1], 1, UINT32_MAX, values[0]) && parse_uint(argv[2], values[0], UINT32_MAX, values[1])) {
+            printf(write_config(offset, values, sizeof(values), SECTION_APP) ? ok_str : error_str);
+        } else {
+            printf(invalid_args_str);
+        }
+    } else {
+        printf(invalid_args_str);
+    }
+}
+
+void join_backoff_func(int argc, char **argv) {
+    backoff_func(argc, argv, offsetof(DeviceConfig_t, app_settings.JoinBackoffMin));
+}
+
+void tx_backoff_func(int argc, char **argv) {
+    backoff_func(argc, argv, offsetof(DeviceConfig_t, app_settings.TxBackoffMin));
+}
+
+void status_func(int argc, char **argv) {
+    shell_response response;
+
+    if (argc != 1) {
+        printf(invalid_args_str);
+    } else if (call_app(ShellMailbox::STATUS, response)) {
+        printf("\r\n%s, %s, next uplink in %lu ms, %lu join and %lu uplink retries\r\n",
+               response.Values[0] ? "connected" : "not connected", response.Values[1] ? "uplink pending" : "idle",
+               response.Values[2], response.Values[3], response.Values[4]);
+    } else {
+        printf(error_str);
+    }
+}
+
+void send_func(int argc, char **argv) {
+    shell_response response;
+
+    if (argc != 1) {
+        printf(invalid_args_str);
+    } else if (call_app(ShellMailbox::SEND_NOW, response)) {
         printf(ok_str);
+    } else {
+        printf(error_str);
+    }
+}
+
+static uint32_t cycles_to_us(uint64_t cycles) {
+    return (uint32_t) (cycles * 1000000 / profile_frequency());
+}
+
+void mem_func(int argc, char **argv) {
+    if (argc == 1) {
+        memory_print();
     } else {
         printf(invalid_args_str);
     }
 }
 
-void appkey_func(int argc, char **argv) {
+void prof_func(int argc, char **argv) {
     if (argc == 1) {
-        print_hex_str(device_config.settings.AppKey, 16);
-        printf("\r\n");
-    } else if (argc == 2 && (strlen(argv[1]) == 32)) {
-        read_hex_str(argv[1], device_config.settings.AppKey, 16);
+        printf("\r\n%-12s %8s %8s %8s %8s\r\n", "probe", "count", "min us", "mean us", "max us");
+        for (uint8_t i = 0; i < PROFILE_PROBE_COUNT; i++) {
+            profile_stats s = profile_get(i);
+            if (s.Count == 0) {
+                printf("%-12s %8d %8s %8s %8s\r\n", profile_name(i), 0, "-", "-", "-");
+                continue;
+            }
+            printf("%-12s %8lu %8lu %8lu %8lu\r\n", profile_name(i), s.Count, cycles_to_us(s.Min),
+                   cycles_to_us(s.Total / s.Count), cycles_to_us(s.Max));
+        }
+    } else if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        profile_reset();
         printf(ok_str);
     } else {
         printf(invalid_args_str);
     }
 }
 
-void ack_retries_func(int argc, char **argv) {
+static void print_queue(const QueueMonitor& queue) {
+    printf("%-12s %8lu %8lu %8lu\r\n", queue.Name(), queue.Pending(), queue.PeakPending(), queue.Failed());
+}
+
+void events_func(int argc, char **argv) {
     if (argc == 1) {
-        printf("\r\n%u\r\n", device_config.settings.ACKAttempts);
-    } else if (argc == 2 && (strlen(argv[1]) == 1)) {
-        read_hex_str(argv[1], &device_config.settings.ACKAttempts, 1);
+        printf("\r\n%-12s %8s %8s %8s\r\n", "queue", "pending", "peak", "failed");
+        print_queue(ev_monitor);
+#if MBED_CONF_APP_MAINTENANCE_QUEUE
+        print_queue(maintenance_monitor);
+#endif
+        printf("%-12s %8s %8s %8s %8s\r\n", "event", "count", "mean ms", "max ms", "run us");
+        for (uint8_t i = 0; i < QUEUE_EVENT_COUNT; i++) {
+            queue_event_stats s = queue_event_get(i);
+            if (s.Count == 0) {
+                printf("%-12s %8d %8s %8s %8s\r\n", queue_event_name(i), 0, "-", "-", "-");
+                continue;
+            }
+            printf("%-12s %8lu %8lu %8lu %8lu\r\n", queue_event_name(i), s.Count, s.LatencyTotal / s.Count,
+                   s.LatencyMax, s.RunMax);
+        }
+    } else if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        ev_monitor.ResetCounters();
+#if MBED_CONF_APP_MAINTENANCE_QUEUE
+        maintenance_monitor.ResetCounters();
+#endif
         printf(ok_str);
     } else {
         printf(invalid_args_str);
     }
 }
 
-void datarate_func(int argc, char **argv) {
+static void print_power_state(const char* name, uint64_t us, uint64_t total_us) {
+    printf("%-12s %10lu ms %3lu%%\r\n", name, (uint32_t) (us / 1000), total_us ? (uint32_t) (us * 100 / total_us) : 0);
+}
+
+void power_func(int argc, char **argv) {
+    if (argc != 1) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    // before printing, pending output holds a lock of its own
+    bool deep_sleep = sleep_manager_can_deep_sleep();
+
+    printf("\r\n");
+#if defined (MBED_CPU_STATS_ENABLED)
+    mbed_stats_cpu_t cpu;
+    mbed_stats_cpu_get(&cpu);
+    uint64_t sleeping = cpu.sleep_time + cpu.deep_sleep_time;
+
+    print_power_state("run", cpu.uptime - cpu.idle_time, cpu.uptime);
+    print_power_state("idle", cpu.idle_time > sleeping ? cpu.idle_time - sleeping : 0, cpu.uptime);
+    print_power_state("sleep", cpu.sleep_time, cpu.uptime);
+    print_power_state("deep sleep", cpu.deep_sleep_time, cpu.uptime);
+#else
+    printf("cpu stats disabled\r\n");
+#endif
+    printf("deep sleep %s, console %s\r\n", deep_sleep ? "allowed" : "locked",
+           console_rx.Listening() ? "listening" : "idle");
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+    flash_power flash;
+    config_mng.FlashPower(flash);
+    uint64_t flash_total = (flash.AwakeTime + flash.SleepTime) * 1000;
+    print_power_state("flash on", flash.AwakeTime * 1000, flash_total);
+    print_power_state("flash off", flash.SleepTime * 1000, flash_total);
+    printf("flash %s, %lu wakeups\r\n", flash.Awake ? "on" : "powered down", flash.Wakeups);
+#endif /* TARGET_MTS_MDOT_F411RE */
+}
+
+void console_func(int argc, char **argv) {
     if (argc == 1) {
-        printf("\r\nDR%u\r\n", device_config.settings.TxDataRate);
-    } else if (argc == 2 && (strlen(argv[1]) == 1)) {
-        read_hex_str(argv[1], &device_config.settings.TxDataRate, 1);
+        printf("\r\nrx %lu bytes, peak %lu, %lu overflows\r\n", console_rx.Size(), console_rx.Peak(),
+               console_rx.Overflows());
+        printf("tx %lu bytes, peak %lu, %lu dropped\r\n", console_tx.Size(), console_tx.Peak(),
+               console_tx.Dropped());
+#if MBED_CONF_APP_TRACE_DEFERRED
+        printf("trace %lu pending, %lu dropped\r\n", deferred_trace.Pending(), deferred_trace.Dropped());
+#endif
+    } else if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        console_rx.ResetCounters();
+        console_tx.ResetCounters();
         printf(ok_str);
     } else {
         printf(invalid_args_str);
     }
 }
 
-void device_class_func(int argc, char **argv) {
+void trace_level_func(int argc, char **argv) {
+    static const char* const names[] = { "none", "error", "warn", "info", "debug" };
+    static const uint8_t levels[] = { TRACE_ACTIVE_LEVEL_NONE, TRACE_ACTIVE_LEVEL_ERROR, TRACE_ACTIVE_LEVEL_WARN,
+                                      TRACE_ACTIVE_LEVEL_INFO, TRACE_ACTIVE_LEVEL_DEBUG };
+
     if (argc == 1) {
-        printf("\r\n%s\r\n", device_config.settings.Class == CLASS_A ? "A" : "C");
-    } else if (argc == 2 && strlen(argv[1]) == 1) {
-        if (argv[1][0] == 'A' || argv[1][0] == 'a') {
-            device_config.settings.Class = CLASS_A;
-            printf(ok_str);
-        } else if (argv[1][0] == 'C' || argv[1][0] == 'c') {
-            device_config.settings.Class = CLASS_C;
-            printf(ok_str);
-        } else {
-            printf(invalid_args_str);
+        const char* name = "custom";
+        for (uint8_t i = 0; i < sizeof(levels); i++) {
+            if ((trace_level & TRACE_MASK_LEVEL) == levels[i]) {
+                name = names[i];
+            }
+        }
+        printf("\r\n%s, %lu dropped\r\n", name, trace_dropped());
+    } else if (argc == 2) {
+        for (uint8_t i = 0; i < sizeof(levels); i++) {
+            if (strcmp(argv[1], names[i]) == 0) {
+                trace_level_set(levels[i]);
+                printf(ok_str);
+                return;
+            }
         }
+        printf(invalid_args_str);
     } else {
         printf(invalid_args_str);
     }
 }
 
-void adr_func(int argc, char **argv) {
+void queue_func(int argc, char **argv) {
+    shell_response response;
+
     if (argc == 1) {
-        printf("\r\n%d\r\n", device_config.settings.EnableADR);
-    } else if (argc == 2 && strlen(argv[1]) == 1) {
-        if (argv[1][0] == '0' || argv[1][0] == '1') {
-            device_config.settings.EnableADR = (argv[1][0] == '1');
+        if (call_app(ShellMailbox::QUEUE_STATUS, response)) {
+            printf("\r\n%lu/%lu pending, %lu dropped, drop %s\r\n", response.Values[0], response.Values[1],
+                   response.Values[2], response.Values[3] ? "oldest" : "newest");
+        } else {
+            printf(error_str);
+        }
+    } else if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        if (call_app(ShellMailbox::QUEUE_CLEAR, response)) {
             printf(ok_str);
         } else {
-            printf(invalid_args_str);
+            printf(error_str);
         }
     } else {
         printf(invalid_args_str);
     }
 }
 
-void app_port_func(int argc, char **argv) {
+/**
+ * Save a section, its dirty flag is cleared first so a change made while
+ * saving is not lost
+ */
+static bool save_section(uint8_t section) {
+    bool saved = false;
+
+    clear_dirty(section);
+    switch (section) {
+        case SECTION_PROTECTED:
+            saved = config_mng.SaveProtected(device_config.provisioning);
+            break;
+        case SECTION_NETWORK:
+            saved = config_mng.Save(device_config.settings);
+            break;
+        case SECTION_APP:
+            saved = config_mng.SaveSettings(device_config.app_settings);
+            break;
+    }
+
+    if (!saved) {
+        mark_dirty(section);
+    }
+    return saved;
+}
+
+void savep_func(int argc, char **argv) {
     if (argc == 1) {
-        printf("\r\n%d\r\n", device_config.settings.Port);
-    } else if (argc == 2) {
-        int val = 1;
-        if (sscanf(argv[1], "%d", &val)) {
-            device_config.settings.Port = val;
+        if (save_section(SECTION_PROTECTED)) {
             printf(ok_str);
         } else {
-            printf(invalid_args_str);
+            printf(error_str);
         }
     } else {
         printf(invalid_args_str);
     }
 }
 
-void duty_cycle_func(int argc, char **argv) {
+void provision_func(int argc, char **argv) {
     if (argc == 1) {
-        printf("\r\n%d\r\n", device_config.app_settings.DutyCycleEnabled);
-    } else if (argc == 2 && strlen(argv[1]) == 1) {
-        if (argv[1][0] == '0' || argv[1][0] == '1') {
-            device_config.app_settings.DutyCycleEnabled = (argv[1][0] == '1');
-            printf(ok_str);
-        } else {
-            printf(invalid_args_str);
-        }
+        // a host that went away without EXIT may not have finished
+        printf(provisioning.Run(provision_timeout) ? ok_str : error_str);
     } else {
         printf(invalid_args_str);
     }
 }
 
-void tx_interval_func(int argc, char **argv) {
+void save_func(int argc, char **argv) {
+    // only changed sections are written, protected settings are left to savep
+    uint8_t sections = dirty_sections() & (SECTION_NETWORK | SECTION_APP);
+
+    if (argc == 2 && strcmp(argv[1], "all") == 0) {
+        sections = SECTION_NETWORK | SECTION_APP;
+    } else if (argc != 1) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    if (((sections & SECTION_NETWORK) && !save_section(SECTION_NETWORK))
+        || ((sections & SECTION_APP) && !save_section(SECTION_APP))) {
+        printf(error_str);
+        return;
+    }
+
+    printf(ok_str);
+}
+
+void get_func(int argc, char **argv) {
     if (argc == 1) {
-        printf("\r\n%lu\r\n", device_config.app_settings.TxInterval);
-    } else if (argc == 2) {
-        int val = 10000;
-        if (sscanf(argv[1], "%d", &val)) {
-            device_config.app_settings.TxInterval = val;
-            printf(ok_str);
-        } else {
+        printf(invalid_args_str);
+        return;
+    }
+
+    uint8_t element;
+    for (int i = 1; i < argc; i++) {
+        if (find_field_element(argv[i], element) == NULL) {
+            printf("\r\nunknown field %s\r\n", argv[i]);
+            return;
+        }
+    }
+
+    printf("\r\n");
+    for (int i = 1; i < argc; i++) {
+        const config_field* field = find_field_element(argv[i], element);
+        printf("%s=", argv[i]);
+        print_field(*field, device_config, element);
+        printf("\r\n");
+    }
+}
+
+void set_func(int argc, char **argv) {
+    uint8_t value[FIELD_MAX_SIZE];
+
+    if (argc == 1) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    // the first pass only validates, nothing is stored unless every pair is valid
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 1; i < argc; i++) {
+            char* separator = strchr(argv[i], '=');
+            const config_field* field = NULL;
+            uint8_t element = FIELD_ALL;
+
+            if (separator) {
+                *separator = 0;
+                field = find_field_element(argv[i], element);
+                *separator = '=';
+            }
+            if (field == NULL || !parse_field(*field, separator + 1, value, element)) {
+                printf("\r\ninvalid %s\r\n", argv[i]);
+                return;
+            }
+            if (pass == 1 && !store_field(*field, value, element)) {
+                printf(error_str);
+                return;
+            }
+        }
+    }
+
+    printf(ok_str);
+}
+
+void dump_func(int argc, char **argv) {
+    static const char* const names[] = { "protected", "network", "app" };
+    uint8_t sections = SECTION_PROTECTED | SECTION_NETWORK | SECTION_APP;
+
+    if (argc == 2) {
+        int choice = parse_choice(argv[1], names, 3);
+        if (choice < 0) {
             printf(invalid_args_str);
+            return;
         }
-    } else {
+        sections = 1 << choice;
+    } else if (argc > 2) {
         printf(invalid_args_str);
+        return;
+    }
+
+    printf("\r\n");
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const config_field& field = config_fields[i];
+        if (field.Section & sections) {
+            printf("%-18s ", field.Name);
+            print_field(field, device_config);
+            printf("\r\n");
+        }
+    }
+
+    uint8_t dirty = dirty_sections();
+    if (dirty) {
+        printf("unsaved:");
+        for (uint8_t section = SECTION_PROTECTED; section <= SECTION_APP; section <<= 1) {
+            if (dirty & section) {
+                printf(" %s", section_name(section));
+            }
+        }
+        printf("\r\n");
     }
 }
 
-void savep_func(int argc, char **argv) {
-    if (argc == 1) {
-        if (config_mng.SaveProtected(device_config.provisioning)) {
-            printf(ok_str);
-        } else {
+#if defined (TARGET_MTS_MDOT_F411RE)
+static void print_bench_result(const char* name, int records, int elapsed_ms) {
+    printf("%-10s %6d records %7d ms %7d records/s\r\n", name, records, elapsed_ms,
+           elapsed_ms > 0 ? (int) ((records * 1000LL) / elapsed_ms) : 0);
+}
+
+void user_file_bench_func(int argc, char **argv) {
+    static const char bench_file[] = "ufbench.dat";
+    static user_stream stream;
+    uint8_t record[64];
+    uint32_t records = 100;
+    uint32_t size = 16;
+
+    if (argc > 3
+            || (argc > 1 && !parse_uint(argv[1], 1, 100000, records))
+            || (argc > 2 && !parse_uint(argv[2], 1, sizeof(record), size))) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        record[i] = i;
+    }
+
+    printf("\r\n");
+    config_mng.DeleteUserFile(bench_file);
+
+    Timer tm;
+    tm.start();
+    for (uint32_t i = 0; i < records; i++) {
+        if (!config_mng.AppendUserFile(bench_file, record, size)) {
+            printf(error_str);
+            return;
+        }
+    }
+    print_bench_result("append", records, tm.read_ms());
+
+    config_mng.DeleteUserFile(bench_file);
+
+    tm.reset();
+    if (!config_mng.OpenUserStream(stream, bench_file, SPIFFS_CREAT | SPIFFS_RDWR | SPIFFS_TRUNC)) {
+        printf(error_str);
+        return;
+    }
+    for (uint32_t i = 0; i < records; i++) {
+        if (config_mng.WriteUserStream(stream, record, size) != (int) size) {
+            config_mng.CloseUserStream(stream);
             printf(error_str);
+            return;
         }
+    }
+    bool flushed = config_mng.FlushUserStream(stream);
+    print_bench_result("stream", records, tm.read_ms());
+
+    tm.reset();
+    config_mng.SeekUserFile(stream.file, 0, SPIFFS_SEEK_SET);
+    uint32_t read = 0;
+    while (read < records && config_mng.ReadUserStream(stream, record, size) == (int) size) {
+        read++;
+    }
+    print_bench_result("read", read, tm.read_ms());
+
+    config_mng.CloseUserStream(stream);
+    config_mng.DeleteUserFile(bench_file);
+
+    printf(flushed && read == records ? ok_str : error_str);
+}
+
+static YmodemReceiver ymodem(console_rx, console_tx);
+static user_stream rx_stream;
+
+static bool rx_write(const uint8_t* data, uint32_t length) {
+    return config_mng.WriteUserStream(rx_stream, data, length) == (int) length;
+}
+
+void rx_func(int argc, char **argv) {
+    static const char* const results[] = {
+        "done", "no file sent", "cancelled", "timed out", "write failed", "protocol error"
+    };
+
+    if (argc != 2 || strlen(argv[1]) > 30) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    // the receiver writes each block to SPIFFS while holding the flash
+    // mutex, which starves the uplink queue while the stack runs
+    if (!require_command_mode()) {
+        return;
+    }
+
+    if (!config_mng.OpenUserStream(rx_stream, argv[1], SPIFFS_CREAT | SPIFFS_RDWR | SPIFFS_TRUNC)) {
+        printf(error_str);
+        return;
+    }
+
+    printf("\r\nstart the YMODEM transfer\r\n");
+    console_tx.Flush(1000);
+
+    YmodemReceiver::Result result = ymodem.Receive(callback(rx_write));
+    bool closed = config_mng.CloseUserStream(rx_stream);
+    int elapsed_ms = ymodem.Duration();
+
+    if (result != YmodemReceiver::DONE || !closed) {
+        // don't leave a partial image behind
+        config_mng.DeleteUserFile(argv[1]);
+        printf("\r\n%s\r\n", results[result]);
+        printf(error_str);
+        return;
+    }
+
+    printf("\r\n%s: %lu bytes in %d ms, %d bytes/s\r\n", ymodem.Name(), ymodem.Received(), elapsed_ms,
+           elapsed_ms > 0 ? (int) ((ymodem.Received() * 1000LL) / elapsed_ms) : 0);
+    printf(ok_str);
+}
+
+static void print_file_entry(const struct spiffs_dirent& entry) {
+    printf("%04x %8lu %s\r\n", entry.obj_id, entry.size, (const char*) entry.name);
+}
+
+void ls_func(int argc, char **argv) {
+    if (argc != 1) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    printf("\r\n  id     size name\r\n");
+    config_mng.ListFiles(callback(print_file_entry));
+}
+
+void df_func(int argc, char **argv) {
+    fs_stats stats;
+
+    if (argc != 1) {
+        printf(invalid_args_str);
+        return;
+    }
+    if (!config_mng.FileSystemStats(stats)) {
+        printf(error_str);
+        return;
+    }
+
+    uint32_t free_pages = stats.Pages - stats.UsedPages - stats.DeletedPages;
+    printf("\r\n%lu pages of %lu bytes, %lu used, %lu deleted, %lu free (%lu bytes)\r\n",
+           stats.Pages, stats.PageSize, stats.UsedPages, stats.DeletedPages, free_pages,
+           free_pages * stats.PageSize);
+    printf("%lu blocks of %lu bytes, %lu free\r\n", stats.Blocks, stats.BlockSize, stats.FreeBlocks);
+    printf("%lu bytes in user files\r\n", config_mng.UsedSpace());
+}
+
+/**
+ * Streams file name through print in chunks, false if it can't be read
+ */
+static bool print_file(const char* name, void (*print)(const uint8_t*, int, uint32_t)) {
+    uint8_t data[64];
+    uint32_t offset = 0;
+
+    file_record file = config_mng.OpenFile(name, SPIFFS_RDONLY);
+    if (file.fd < 0) {
+        return false;
+    }
+
+    while (offset < file.size) {
+        int length = config_mng.ReadUserFile(file, data, sizeof(data));
+        if (length <= 0) {
+            break;
+        }
+        print(data, length, offset);
+        offset += length;
+    }
+
+    config_mng.CloseUserFile(file);
+    return offset == file.size;
+}
+
+static void print_raw(const uint8_t* data, int length, uint32_t offset) {
+    console_tx.write(data, length);
+}
+
+static void print_hex(const uint8_t* data, int length, uint32_t offset) {
+    for (int line = 0; line < length; line += 16) {
+        printf("%08lx ", offset + line);
+        for (int i = line; i < line + 16; i++) {
+            if (i < length) {
+                printf(" %02x", data[i]);
+            } else {
+                printf("   ");
+            }
+        }
+        printf("  ");
+        for (int i = line; i < line + 16 && i < length; i++) {
+            printf("%c", data[i] >= 0x20 && data[i] < 0x7f ? data[i] : '.');
+        }
+        printf("\r\n");
+    }
+}
+
+void cat_func(int argc, char **argv) {
+    if (argc != 2) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    printf("\r\n");
+    printf(print_file(argv[1], print_raw) ? ok_str : error_str);
+}
+
+void hexdump_func(int argc, char **argv) {
+    if (argc != 2) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    printf("\r\n");
+    printf(print_file(argv[1], print_hex) ? ok_str : error_str);
+}
+
+void rm_func(int argc, char **argv) {
+    if (argc != 2) {
+        printf(invalid_args_str);
+        return;
+    }
+
+    // only user files, ls shows them with their u_ prefix
+    const char* name = strncmp(argv[1], "u_", 2) == 0 ? argv[1] + 2 : argv[1];
+
+    if (strlen(name) == 0 || strlen(name) > 30) {
+        printf(invalid_args_str);
+    } else if (config_mng.UserFileOpen(name)) {
+        printf("\r\n%s is open\r\n", name);
+        printf(error_str);
     } else {
+        printf(config_mng.DeleteUserFile(name) ? ok_str : error_str);
+    }
+}
+
+static const char* check_phase;
+static uint8_t check_percent;
+
+static void print_check_progress(const char* phase, uint8_t percent) {
+    // a line per phase, a mark every 10%
+    if (phase != check_phase) {
+        printf("\r\n%-6s ", phase);
+        check_phase = phase;
+        check_percent = 0;
+    }
+    while (check_percent + 10 <= percent) {
+        check_percent += 10;
+        printf(".");
+    }
+}
+
+void fsck_func(int argc, char **argv) {
+    fs_check result;
+
+    if (argc != 1) {
         printf(invalid_args_str);
+        return;
     }
+    if (!require_command_mode()) {
+        return;
+    }
+
+    check_phase = NULL;
+    bool ok = config_mng.Check(result, callback(print_check_progress));
+    printf("\r\n%lu errors, %lu fixed in %lu ms\r\n", result.Errors, result.Fixes, result.Duration);
+    printf(ok ? ok_str : error_str);
 }
 
-void save_func(int argc, char **argv) {
-    if (argc == 1) {
-        if (config_mng.Save(device_config.settings)
-            && config_mng.SaveSettings(device_config.app_settings)) {
-            printf(ok_str);
-        } else {
-            printf(error_str);
+static void print_bench_row(const char* name, uint32_t size, uint32_t count, uint64_t total_us) {
+    uint32_t per_op = count > 0 ? total_us / count : 0;
+
+    printf("%-12s ", name);
+    if (size > 0) {
+        printf("%6lu ", size);
+    } else {
+        printf("%6s ", "-");
+    }
+    printf("%5lu %9lu ", count, per_op);
+    if (size > 0 && total_us > 0) {
+        printf("%7lu\r\n", (uint32_t) ((uint64_t) size * count * 1000000 / 1024 / total_us));
+    } else {
+        printf("%7s\r\n", "-");
+    }
+}
+
+void bench_func(int argc, char **argv) {
+    static const char* const names[] = { "bench0", "bench1", "bench2", "bench3", "bench4",
+                                         "bench5", "bench6", "bench7", "bench8", "bench9" };
+    static const char big_file[] = "bench.dat";
+    static const uint32_t big_size = 16 * 1024;
+    static const int appends = 100;
+    static const uint8_t files = sizeof(names) / sizeof(names[0]);
+    static user_stream stream;
+    uint8_t data[64];
+    flash_bench flash;
+    uint32_t mount_ms;
+    bool ok = true;
+
+    if (argc != 1) {
+        printf(invalid_args_str);
+        return;
+    }
+    if (!require_command_mode()) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = i;
+    }
+
+    printf("\r\n%-12s %6s %5s %9s %7s\r\n", "test", "bytes", "count", "us/op", "KB/s");
+
+    if (config_mng.BenchmarkFlash(flash)) {
+        for (uint8_t i = 0; i < FLASH_BENCH_READ_SIZES; i++) {
+            print_bench_row("flash read", flash.ReadSize[i], 1, flash.ReadTime[i]);
         }
+        print_bench_row("page program", PAGE_SIZE, flash.Pages, flash.ProgramTotal);
+        printf("%-12s %6s %5s %9lu %7lu\r\n", "", "min", "max", flash.ProgramMin, flash.ProgramMax);
+        print_bench_row("block erase", SECTOR_SIZE, 1, flash.EraseTime);
     } else {
+        printf("flash        failed\r\n");
+        ok = false;
+    }
+
+    // the uplink queue keeps its log open, SPIFFS can't unmount under it
+    uplink_queue.Close();
+    if (config_mng.Remount(mount_ms)) {
+        print_bench_row("fs mount", 0, 1, mount_ms * 1000ULL);
+    } else {
+        printf("fs mount     failed, close open files first\r\n");
+        ok = false;
+    }
+    ok = uplink_queue.Open() && ok;
+
+    Timer tm;
+    tm.start();
+    for (uint8_t i = 0; i < files; i++) {
+        ok = config_mng.SaveUserFile(names[i], data, 32) && ok;
+    }
+    print_bench_row("fs create", 32, files, tm.read_us());
+
+    tm.reset();
+    if (config_mng.OpenUserStream(stream, big_file, SPIFFS_CREAT | SPIFFS_RDWR | SPIFFS_TRUNC)) {
+        for (uint32_t written = 0; written < big_size; written += sizeof(data)) {
+            ok = config_mng.WriteUserStream(stream, data, sizeof(data)) == (int) sizeof(data) && ok;
+        }
+        ok = config_mng.FlushUserStream(stream) && ok;
+        print_bench_row("fs write", big_size, 1, tm.read_us());
+
+        tm.reset();
+        config_mng.SeekUserFile(stream.file, 0, SPIFFS_SEEK_SET);
+        uint32_t read = 0;
+        while (read < big_size && config_mng.ReadUserStream(stream, data, sizeof(data)) == (int) sizeof(data)) {
+            read += sizeof(data);
+        }
+        print_bench_row("fs read", read, 1, tm.read_us());
+        ok = read == big_size && config_mng.CloseUserStream(stream) && ok;
+    } else {
+        ok = false;
+    }
+
+    tm.reset();
+    for (int i = 0; i < appends; i++) {
+        ok = config_mng.AppendUserFile(names[0], data, 16) && ok;
+    }
+    print_bench_row("fs append", 16, appends, tm.read_us());
+
+    tm.reset();
+    for (uint8_t i = 0; i < files; i++) {
+        config_mng.DeleteUserFile(names[i]);
+    }
+    config_mng.DeleteUserFile(big_file);
+    print_bench_row("fs delete", 0, files + 1, tm.read_us());
+
+    printf(ok ? ok_str : error_str);
+}
+#endif /* TARGET_MTS_MDOT_F411RE */
+
+typedef struct {
+        const char* Name;
+        const char* Help;
+        const char* Usage;
+        void (*Handler)(int argc, char **argv);   // NULL for settings
+        const config_field* Field;                // setting shown or set
+} shell_command;
+
+#define SHELL_COMMAND(name, help, usage, handler) \
+    { #name, help, usage, handler, NULL },
+#define SHELL_SETTING(name, help) \
+    { #name, help, NULL, NULL, &config_fields[FIELD_##name] },
+
+static const shell_command commands[] = {
+#include "command_list.h"
+};
+
+#undef SHELL_COMMAND
+#undef SHELL_SETTING
+
+static const uint8_t command_count = sizeof(commands) / sizeof(commands[0]);
+
+#include "command_hash.h"
+
+/**
+ * FNV-1a from the generated seed, tools/command_hash.py computes the same
+ */
+static uint32_t command_hash(const char* name) {
+    uint32_t hash = COMMAND_HASH_SEED;
+
+    while (*name) {
+        hash = (hash ^ (uint8_t) *name++) * 16777619UL;
+    }
+
+    return hash;
+}
+
+static const shell_command* find_command(const char* name) {
+    uint8_t slot = command_slots[command_hash(name) >> (32 - COMMAND_HASH_BITS)];
+
+    // commands of other targets leave slots past the end of the table
+    if (slot == 0 || slot > command_count || strcmp(commands[slot - 1].Name, name) != 0) {
+        return NULL;
+    }
+
+    return &commands[slot - 1];
+}
+
+void help_func(int argc, char **argv) {
+    if (argc == 1) {
+        printf("\r\n");
+        for (uint8_t i = 0; i < command_count; i++) {
+            printf("%-11s %s\r\n", commands[i].Name, commands[i].Help);
+        }
+        return;
+    }
+
+    const shell_command* command = argc == 2 ? find_command(argv[1]) : NULL;
+    if (command == NULL) {
         printf(invalid_args_str);
+        return;
+    }
+
+    printf("\r\n%s: %s\r\nusage: %s ", command->Name, command->Help, command->Name);
+    if (command->Field) {
+        print_field_range(*command->Field);
+    } else {
+        printf("%s", command->Usage);
     }
+    printf("\r\n");
 }
 
-void tinysh_char_out(unsigned char c) {
-    pc.putc(c);
+static void setting_func(const config_field& field, int argc, char **argv) {
+    uint8_t value[FIELD_MAX_SIZE];
+
+    if (argc == 1) {
+        printf("\r\n");
+        print_field(field, device_config);
+        printf("\r\n");
+    } else if (argc == 2 && parse_field(field, argv[1], value)) {
+        printf(store_field(field, value) ? ok_str : error_str);
+    } else {
+        printf(invalid_args_str);
+    }
 }
 
-void tinyshell_thread() {
-    pc.printf("MTS LoRaWAN shell build %s %s\r\n", __DATE__, __TIME__);
+/**
+ * Split line in place at spaces and run the command it names
+ */
+static void execute(char* line) {
+    static const uint8_t max_args = 16;
+    char* argv[max_args];
+    int argc = 0;
 
-    tinysh_set_prompt(prompt);
-    tinysh_add_command(&reset_cmd);
-    tinysh_add_command(&run_cmd);
-    tinysh_add_command(&deveui_cmd);
-    tinysh_add_command(&appeui_cmd);
-    tinysh_add_command(&appkey_cmd);
-    tinysh_add_command(&ack_retries_cmd);
-    tinysh_add_command(&datarate_cmd);
-    tinysh_add_command(&device_class_cmd);
-    tinysh_add_command(&adr_cmd);
-    tinysh_add_command(&app_port_cmd);
-    tinysh_add_command(&tx_interval_cmd);
-    tinysh_add_command(&duty_cycle_cmd);
-    tinysh_add_command(&savep_cmd);
-    tinysh_add_command(&save_cmd);
+    for (char* p = line; *p && argc < max_args; ) {
+        while (*p == ' ' || *p == '\t') {
+            *p++ = 0;
+        }
+        if (*p) {
+            argv[argc++] = p;
+        }
+        while (*p && *p != ' ' && *p != '\t') {
+            p++;
+        }
+    }
 
-    while (!exit_cmd_mode) {
-        tinysh_char_in(pc.getc());
+    if (argc == 0) {
+        printf("\r\n");
+        return;
     }
 
+    const shell_command* command = find_command(argv[0]);
+    if (command == NULL) {
+        printf("\r\nunknown command\r\n");
+    } else if (command->Handler != NULL) {
+        command->Handler(argc, argv);
+    } else {
+        setting_func(*command->Field, argc, argv);
+    }
 }
 
+void tinyshell_thread() {
+    static char line[128];
+    uint8_t length = 0;
+    bool cr = false;
+
+    printf("MTS LoRaWAN shell build %s %s\r\n", __DATE__, __TIME__);
+
+    for (uint8_t i = 0; i < command_count; i++) {
+        if (find_command(commands[i].Name) != &commands[i]) {
+            printf("command hash out of date, run tools/command_hash.py\r\n");
+            break;
+        }
+    }
+
+    printf(prompt);
 
+    // sleeps until the RX interrupt delivers input, then handles all of it,
+    // pasted lines don't need a wakeup per character
+    uint8_t input[16];
+    while (true) {
+        uint32_t count = console_rx.Read(input, sizeof(input));
+        for (uint32_t i = 0; i < count; i++) {
+            char c = input[i];
 
+            if (c == '\n' && cr) {
+                // second half of CR LF
+                cr = false;
+                continue;
+            }
+            cr = c == '\r';
 
+            if (c == '\r' || c == '\n') {
+                line[length] = 0;
+                execute(line);
+                length = 0;
+                printf(prompt);
+            } else if (c == '\b' || c == 0x7f) {
+                if (length > 0) {
+                    length--;
+                    printf("\b \b");
+                }
+            } else if (c == 0x03 || c == 0x15) {
+                // ctrl-c, ctrl-u
+                length = 0;
+                printf("\r\n%s", prompt);
+            } else if (c >= 0x20 && c < 0x7f && length < sizeof(line) - 1) {
+                line[length++] = c;
+                console_tx.write(&c, 1);
+            }
+        }
+    }
+}
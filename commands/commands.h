@@ -30,24 +30,45 @@
 #define __MTS_LORA_COMMANDS__
 
 #include "mbed.h"
-#include "tinysh.h"
 #include "config.h"
 
+/**
+ * Entry of the shell thread, commands that touch the running application
+ * go through shell_mailbox
+ */
 void tinyshell_thread();
+void help_func(int argc, char **argv);
 void reset_func(int argc, char **argv);
 void run_func(int argc, char **argv);
-void deveui_func(int argc, char **argv);
-void appeui_func(int argc, char **argv);
-void appkey_func(int argc, char **argv);
-void ack_retries_func(int argc, char **argv);
-void datarate_func(int argc, char **argv);
 void device_class_func(int argc, char **argv);
-void adr_func(int argc, char **argv);
-void app_port_func(int argc, char **argv);
-void duty_cycle_func(int argc, char **argv);
-void tx_interval_func(int argc, char **argv);
+void join_backoff_func(int argc, char **argv);
+void tx_backoff_func(int argc, char **argv);
+void status_func(int argc, char **argv);
+void send_func(int argc, char **argv);
+void queue_func(int argc, char **argv);
+void console_func(int argc, char **argv);
+void prof_func(int argc, char **argv);
+void mem_func(int argc, char **argv);
+void events_func(int argc, char **argv);
+void power_func(int argc, char **argv);
+void trace_level_func(int argc, char **argv);
 void savep_func(int argc, char **argv);
 void save_func(int argc, char **argv);
+void get_func(int argc, char **argv);
+void set_func(int argc, char **argv);
+void dump_func(int argc, char **argv);
+void provision_func(int argc, char **argv);
+#if defined (TARGET_MTS_MDOT_F411RE)
+void user_file_bench_func(int argc, char **argv);
+void rx_func(int argc, char **argv);
+void ls_func(int argc, char **argv);
+void df_func(int argc, char **argv);
+void cat_func(int argc, char **argv);
+void hexdump_func(int argc, char **argv);
+void rm_func(int argc, char **argv);
+void fsck_func(int argc, char **argv);
+void bench_func(int argc, char **argv);
+#endif /* TARGET_MTS_MDOT_F411RE */
 
 
 #endif
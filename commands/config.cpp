@@ -27,12 +27,18 @@
 */
 
 #include "config.h"
+#include "crc16.h"
+#include "profiler.h"
+#include "memory_monitor.h"
 
 #if defined (TARGET_MTS_MDOT_F411RE)
+#include "spiffs_nucleus.h"
+
 char ConfigManager::file[] = "lora.cfg";
 char ConfigManager::protected_file[] = "mdot.cfg";
 char ConfigManager::session_file[] = "lora.session";
 char ConfigManager::app_settings_file[] = "app.settings";
+char ConfigManager::journal_file[] = "prov.journal";
 char ConfigManager::user_dir[] = "user";
 
 Mutex mutex;
@@ -44,13 +50,26 @@ u8_t ConfigManager::spiffs_cache_buf[(PAGE_SIZE + 32) * 4];
 
 spiffs ConfigManager::_fs;
 
+// the flash may still be powered down from before a reset, the constructor
+// releases it
+bool ConfigManager::_flash_asleep = true;
+uint32_t ConfigManager::_flash_wakeups;
+uint64_t ConfigManager::_flash_changed;
+uint64_t ConfigManager::_flash_used;
+uint64_t ConfigManager::_flash_time[2];
+Callback<void()> ConfigManager::_flash_wakeup;
+
 // glue code between SPI driver and filesystem
 int ConfigManager::spi_read(unsigned int addr, unsigned int size, unsigned char* data) {
+    PROFILE_SCOPE(PROFILE_SPIFFS_READ);
+    WakeFlash();
     if (_flash.read(addr, size, (char*) data))
         return SPIFFS_OK;
     return -1;
 }
 int ConfigManager::spi_write(unsigned int addr, unsigned int size, unsigned char* data) {
+    PROFILE_SCOPE(PROFILE_SPIFFS_WRITE);
+    WakeFlash();
     if (_flash.write(addr, size, (const char*) data))
         return SPIFFS_OK;
     return -1;
@@ -133,6 +152,30 @@ bool ConfigManager::DeleteUserFile(const char* file) {
     return handle == SPIFFS_OK;
 }
 
+bool ConfigManager::UserFileOpen(const char* file) {
+    if(PVDO())
+        return false;
+
+    char filename[32];
+    snprintf(filename, 32, "u_%s", file);
+
+    spiffs_stat stat;
+    bool open = false;
+
+    mutex.lock();
+    if (SPIFFS_stat(&_fs, filename, &stat) == SPIFFS_OK) {
+        spiffs_fd* fds = (spiffs_fd*) _fs.fd_space;
+        for (uint32_t i = 0; i < _fs.fd_count; i++) {
+            if (fds[i].file_nbr != 0 && (fds[i].obj_id & ~SPIFFS_OBJ_ID_IX_FLAG) == stat.obj_id) {
+                open = true;
+            }
+        }
+    }
+    mutex.unlock();
+
+    return open;
+}
+
 bool ConfigManager::DeleteFile(const char* file) {
     if(PVDO())
         return false;
@@ -167,6 +210,228 @@ uint32_t ConfigManager::UsedSpace() {
     return used_space;
 }
 
+void ConfigManager::ListFiles(Callback<void(const struct spiffs_dirent&)> visit) {
+    if(PVDO())
+        return;
+
+    spiffs_DIR dir;
+    spiffs_dirent entry;
+
+    SPIFFS_opendir(&_fs, user_dir, &dir);
+
+    // the lock is not held while the caller prints
+    while (true) {
+        mutex.lock();
+        bool found = SPIFFS_readdir(&dir, &entry) != NULL;
+        mutex.unlock();
+
+        if (!found)
+            break;
+        visit(entry);
+    }
+
+    SPIFFS_closedir(&dir);
+}
+
+file_record ConfigManager::OpenFile(const char* file, int mode) {
+    return OpenFile(&_fs, file, mode);
+}
+
+bool ConfigManager::FileSystemStats(fs_stats& stats) {
+    if(PVDO())
+        return false;
+
+    mutex.lock();
+    stats.PageSize = _fs.cfg.log_page_size;
+    stats.BlockSize = _fs.cfg.log_block_size;
+    stats.Blocks = _fs.block_count;
+    stats.FreeBlocks = _fs.free_blocks;
+    stats.UsedPages = _fs.stats_p_allocated;
+    stats.DeletedPages = _fs.stats_p_deleted;
+    mutex.unlock();
+
+    // each block starts with its object lookup pages, as SPIFFS_OBJ_LOOKUP_PAGES
+    uint32_t pages_per_block = stats.BlockSize / stats.PageSize;
+    uint32_t lookup_pages = pages_per_block * sizeof(spiffs_obj_id) / stats.PageSize;
+    if (lookup_pages < 1)
+        lookup_pages = 1;
+
+    stats.Pages = stats.Blocks * (pages_per_block - lookup_pages);
+    return true;
+}
+
+// SPIFFS reports the check through a plain function, it only runs from Check
+static fs_check* check_result;
+static Callback<void(const char*, uint8_t)> check_progress;
+
+void ConfigManager::check_report(spiffs_check_type type, spiffs_check_report report, u32_t arg1, u32_t arg2) {
+    static const char* const phases[] = { "lookup", "index", "page" };
+
+    if (check_result == NULL)
+        return;
+
+    switch (report) {
+        case SPIFFS_CHECK_PROGRESS:
+            if (check_progress)
+                check_progress(phases[type], (uint8_t) (arg1 * 100 / 256));
+            break;
+        case SPIFFS_CHECK_ERROR:
+            check_result->Errors++;
+            break;
+        default:
+            check_result->Fixes++;
+            break;
+    }
+}
+
+bool ConfigManager::Check(fs_check& result, Callback<void(const char*, uint8_t)> progress) {
+    if(PVDO())
+        return false;
+
+    memset(&result, 0, sizeof(result));
+
+    mutex.lock();
+    check_result = &result;
+    check_progress = progress;
+
+    uint64_t start = Kernel::get_ms_count();
+    int ret = SPIFFS_check(&_fs);
+    result.Duration = Kernel::get_ms_count() - start;
+
+    check_result = NULL;
+    check_progress = NULL;
+    mutex.unlock();
+
+    if (ret != SPIFFS_OK)
+        printf("SPIFFS_check failed %d", SPIFFS_errno(&_fs));
+
+    return ret == SPIFFS_OK;
+}
+
+// large enough for the biggest benchmark read and an object lookup page
+static char bench_buffer[1024];
+
+bool ConfigManager::BenchmarkFlash(flash_bench& result) {
+    static const uint16_t read_sizes[FLASH_BENCH_READ_SIZES] = { 16, 256, 1024 };
+    static const uint16_t reads = 16;
+    static const uint16_t pages = 16;
+
+    if(PVDO())
+        return false;
+
+    memset(&result, 0, sizeof(result));
+
+    // nothing may allocate in the block while it is borrowed
+    mutex.lock();
+    WakeFlash();
+
+    uint32_t block_size = _fs.cfg.log_block_size;
+    uint32_t page_size = _fs.cfg.log_page_size;
+    uint32_t lookup_pages = (block_size / page_size) * sizeof(spiffs_obj_id) / page_size;
+    if (lookup_pages < 1)
+        lookup_pages = 1;
+    uint32_t entries = lookup_pages * page_size / sizeof(spiffs_obj_id);
+
+    // a free block has only erased lookup entries, apart from the erase
+    // count SPIFFS keeps in the last one, search from the end where new
+    // files are least likely
+    bool found = false;
+    spiffs_obj_id erase_count = 0;
+    for (int32_t block = _fs.block_count - 1; block >= 0 && !found; block--) {
+        uint32_t address = block * block_size;
+        found = true;
+
+        for (uint32_t offset = 0; offset < lookup_pages * page_size && found; offset += page_size) {
+            _flash.read(address + offset, page_size, bench_buffer);
+            spiffs_obj_id* ids = (spiffs_obj_id*) bench_buffer;
+
+            for (uint32_t i = 0; i < page_size / sizeof(spiffs_obj_id); i++) {
+                if (offset / sizeof(spiffs_obj_id) + i == entries - 1) {
+                    erase_count = ids[i];
+                } else if (ids[i] != (spiffs_obj_id) -1) {
+                    found = false;
+                    break;
+                }
+            }
+        }
+
+        result.Address = address;
+    }
+
+    if (!found) {
+        mutex.unlock();
+        printf("No free block to benchmark");
+        return false;
+    }
+
+    Timer tm;
+    tm.start();
+
+    for (uint8_t i = 0; i < FLASH_BENCH_READ_SIZES; i++) {
+        result.ReadSize[i] = read_sizes[i];
+        tm.reset();
+        for (uint16_t n = 0; n < reads; n++) {
+            _flash.read(n * read_sizes[i], read_sizes[i], bench_buffer);
+        }
+        result.ReadTime[i] = tm.read_us() / reads;
+    }
+
+    for (uint32_t i = 0; i < page_size; i++) {
+        bench_buffer[i] = i;
+    }
+
+    bool ret = true;
+    uint32_t data = result.Address + lookup_pages * page_size;
+    for (uint16_t n = 0; n < pages && ret; n++) {
+        tm.reset();
+        ret = _flash.write(data + n * page_size, page_size, bench_buffer);
+        uint32_t elapsed = tm.read_us();
+
+        if (n == 0 || elapsed < result.ProgramMin)
+            result.ProgramMin = elapsed;
+        if (elapsed > result.ProgramMax)
+            result.ProgramMax = elapsed;
+        result.ProgramTotal += elapsed;
+        result.Pages++;
+    }
+
+    // check the last page made it before wiping the evidence
+    char check[16];
+    ret = ret && _flash.read(data + (pages - 1) * page_size, sizeof(check), check)
+        && memcmp(check, bench_buffer, sizeof(check)) == 0;
+
+    tm.reset();
+    _flash.clear_sector(result.Address);
+    result.EraseTime = tm.read_us();
+
+    // back to what SPIFFS left there
+    _flash.write(result.Address + (entries - 1) * sizeof(spiffs_obj_id), sizeof(erase_count), (const char*) &erase_count);
+
+    mutex.unlock();
+    return ret;
+}
+
+bool ConfigManager::Remount(uint32_t& duration_ms) {
+    if(PVDO())
+        return false;
+
+    mutex.lock();
+    if (_openFds != 0) {
+        mutex.unlock();
+        return false;
+    }
+
+    Timer tm;
+    tm.start();
+    SPIFFS_unmount(&_fs);
+    Mount();
+    duration_ms = tm.read_ms();
+
+    mutex.unlock();
+    // as SPIFFS_CHECK_MOUNT
+    return _fs.block_count > 0;
+}
+
 bool ConfigManager::AppendUserFile(const char* file, void* data, uint32_t size) {
     if(PVDO())
         return false;
@@ -217,6 +482,15 @@ int ConfigManager::WriteUserFile(file_record& file, void* data, size_t length) {
     return WriteFile(&_fs, file, data, length);
 }
 
+bool ConfigManager::FlushUserFile(file_record& file) {
+    if(PVDO())
+        return false;
+    mutex.lock();
+    int ret = SPIFFS_fflush(&_fs, file.fd);
+    mutex.unlock();
+    return ret >= 0;
+}
+
 bool ConfigManager::CloseUserFile(file_record& file) {
     return CloseFile(&_fs, file);
 }
@@ -253,8 +527,8 @@ file_record ConfigManager::OpenFile(spiffs* fs, const char* file, int mode) {
                 mf.size = stat.size;
             }
         }
-        mutex.unlock();
     }
+    mutex.unlock();
     return mf;
 }
 
@@ -346,12 +620,137 @@ bool ConfigManager::MoveUserFileToFirwareUpgrade(const char* file) {
 
     return MoveFile(&_fs, filename, "fw_upgrade.bin");
 }
+
+bool ConfigManager::OpenUserStream(user_stream& stream, const char* file, int mode) {
+    stream.length = 0;
+    stream.offset = 0;
+    stream.writing = false;
+    stream.file = OpenUserFile(file, mode);
+
+    return stream.file.fd >= 0;
+}
+
+int ConfigManager::WriteUserStream(user_stream& stream, const void* data, size_t length) {
+    const uint8_t* src = (const uint8_t*) data;
+    size_t written = 0;
+
+    if (!stream.writing) {
+        // drop any read-ahead and put the file position back where the caller left it
+        if (stream.length > stream.offset
+                && !SeekFile(&_fs, stream.file, stream.offset - stream.length, SPIFFS_SEEK_CUR)) {
+            return -1;
+        }
+        stream.length = 0;
+        stream.offset = 0;
+        stream.writing = true;
+    }
+
+    while (written < length) {
+        size_t chunk = length - written;
+
+        if (stream.length == 0 && chunk >= PAGE_SIZE) {
+            // whole pages go straight through, there is nothing to coalesce
+            chunk -= chunk % PAGE_SIZE;
+            if (WriteFile(&_fs, stream.file, (void*) (src + written), chunk) < 0) {
+                return -1;
+            }
+        } else {
+            if (chunk > (size_t) (PAGE_SIZE - stream.length)) {
+                chunk = PAGE_SIZE - stream.length;
+            }
+            memcpy(stream.buffer + stream.length, src + written, chunk);
+            stream.length += chunk;
+
+            if (stream.length == PAGE_SIZE && !FlushUserStream(stream)) {
+                return -1;
+            }
+        }
+
+        written += chunk;
+    }
+
+    return written;
+}
+
+int ConfigManager::ReadUserStream(user_stream& stream, void* data, size_t length) {
+    uint8_t* dest = (uint8_t*) data;
+    size_t read = 0;
+
+    if (stream.writing) {
+        if (!FlushUserStream(stream)) {
+            return -1;
+        }
+        stream.writing = false;
+    }
+
+    while (read < length) {
+        if (stream.offset == stream.length) {
+            stream.offset = 0;
+            stream.length = 0;
+
+            if (length - read >= PAGE_SIZE) {
+                // large reads bypass the read-ahead buffer
+                int ret = ReadFile(&_fs, stream.file, dest + read, length - read);
+                if (ret > 0) {
+                    read += ret;
+                }
+                break;
+            }
+
+            int ret = ReadFile(&_fs, stream.file, stream.buffer, PAGE_SIZE);
+            if (ret <= 0) {
+                // SPIFFS reports end of file as an error
+                break;
+            }
+            stream.length = ret;
+        }
+
+        size_t chunk = stream.length - stream.offset;
+        if (chunk > length - read) {
+            chunk = length - read;
+        }
+        memcpy(dest + read, stream.buffer + stream.offset, chunk);
+        stream.offset += chunk;
+        read += chunk;
+    }
+
+    return read;
+}
+
+bool ConfigManager::FlushUserStream(user_stream& stream) {
+    if (!stream.writing) {
+        return true;
+    }
+
+    if (stream.length > 0) {
+        int ret = WriteFile(&_fs, stream.file, stream.buffer, stream.length);
+        if (ret < 0) {
+            printf("SPIFFS_write failed %d", SPIFFS_errno(&_fs));
+            return false;
+        }
+        stream.length = 0;
+    }
+
+    return FlushUserFile(stream.file);
+}
+
+bool ConfigManager::CloseUserStream(user_stream& stream) {
+    bool ret = FlushUserStream(stream);
+
+    stream.length = 0;
+    stream.offset = 0;
+    stream.writing = false;
+
+    return CloseUserFile(stream.file) && ret;
+}
 #endif /* TARGET_MTS_MDOT_F411RE */
 
 
 #if defined (TARGET_MTS_MDOT_F411RE)
 int ConfigManager::spi_erase(unsigned int addr, unsigned int size) {
+    PROFILE_SCOPE(PROFILE_SPIFFS_ERASE);
     mutex.lock();
+    WakeFlash();
     _flash.clear_sector(addr);
     mutex.unlock();
     return SPIFFS_OK;
@@ -362,6 +761,7 @@ ConfigManager::ConfigManager()
 {
 #if defined (TARGET_MTS_MDOT_F411RE)
     EnablePVD();
+    memory_add_buffer("spiffs", sizeof(spiffs_work_buf) + sizeof(spiffs_fds) + sizeof(spiffs_cache_buf));
 #endif /* TARGET_MTS_MDOT_F411RE */
     Wakeup();
     Mount();
@@ -369,16 +769,82 @@ ConfigManager::ConfigManager()
 
 void ConfigManager::Sleep() {
 #if defined (TARGET_MTS_MDOT_F411RE)
-    _flash.deep_power_down();
+    mutex.lock();
+    if (!_flash_asleep) {
+        _flash.deep_power_down();
+        FlashState(true);
+    }
+    mutex.unlock();
 #endif /* TARGET_MTS_MDOT_F411RE */
 }
 
 void ConfigManager::Wakeup() {
 #if defined (TARGET_MTS_MDOT_F411RE)
-    _flash.wakeup();
+    WakeFlash();
 #endif /* TARGET_MTS_MDOT_F411RE */
 }
 
+#if defined (TARGET_MTS_MDOT_F411RE)
+void ConfigManager::FlashState(bool asleep) {
+    uint64_t now = Kernel::get_ms_count();
+
+    _flash_time[_flash_asleep] += now - _flash_changed;
+    _flash_changed = now;
+    _flash_asleep = asleep;
+}
+
+void ConfigManager::WakeFlash() {
+    mutex.lock();
+    bool woke = _flash_asleep;
+    if (woke) {
+        _flash.wakeup();
+        wait_us(FlashWakeupTime);
+        FlashState(false);
+        _flash_wakeups++;
+    }
+    _flash_used = Kernel::get_ms_count();
+    mutex.unlock();
+
+    if (woke && _flash_wakeup) {
+        _flash_wakeup.call();
+    }
+}
+
+bool ConfigManager::SleepIfIdle(uint32_t idle_ms, uint32_t& remaining) {
+    remaining = idle_ms;
+
+    // don't wait for a long write, the caller tries again later
+    if (!mutex.trylock()) {
+        return false;
+    }
+
+    uint64_t idle = Kernel::get_ms_count() - _flash_used;
+    bool sleep = _flash_asleep || idle >= idle_ms;
+    if (sleep) {
+        Sleep();
+    } else {
+        remaining = idle_ms - idle;
+    }
+
+    mutex.unlock();
+    return sleep;
+}
+
+void ConfigManager::OnFlashWakeup(Callback<void()> wakeup) {
+    _flash_wakeup = wakeup;
+}
+
+void ConfigManager::FlashPower(flash_power& power) {
+    mutex.lock();
+    uint64_t current = Kernel::get_ms_count() - _flash_changed;
+    power.Awake = !_flash_asleep;
+    power.Wakeups = _flash_wakeups;
+    power.AwakeTime = _flash_time[0] + (_flash_asleep ? 0 : current);
+    power.SleepTime = _flash_time[1] + (_flash_asleep ? current : 0);
+    mutex.unlock();
+}
+#endif /* TARGET_MTS_MDOT_F411RE */
+
 #if defined (TARGET_MTS_MDOT_F411RE)
 void ConfigManager::EnablePVD(){
     PWR->CR &= ~PWR_CR_PLS;
@@ -416,7 +882,7 @@ void ConfigManager::Mount() {
     mutex.lock();
     int ret = SPIFFS_mount(&_fs, &cfg, spiffs_work_buf, spiffs_fds, sizeof(spiffs_fds), spiffs_cache_buf,
                            sizeof(spiffs_cache_buf),
-                           NULL);
+                           &check_report);
     mutex.unlock();
     if (ret) {
         printf("SPIFFS_mount failed %d - can't continue", ret);
@@ -474,6 +940,111 @@ bool ConfigManager::Save(NetworkSettings_t& n) {
     return ret;
 }
 
+bool ConfigManager::SaveProvisioning(ProtectedSettings_t& p, NetworkSettings_t& n) {
+    if (!WriteJournal(p, n)) {
+        return false;
+    }
+
+    // from here on a reset is recovered from the journal
+    if (!SaveProtected(p) || !Save(n)) {
+        return false;
+    }
+
+    return ClearJournal();
+}
+
+bool ConfigManager::WriteJournal(ProtectedSettings_t& p, NetworkSettings_t& n) {
+    ScopedRomWriteLock make_rom_writable;
+    ProvisioningJournal_t journal;
+
+    journal.Magic = PROVISIONING_JOURNAL_MAGIC;
+    journal.Crc = crc16(&n, sizeof(n), crc16(&p, sizeof(p)));
+    journal.Length = sizeof(p) + sizeof(n);
+
+    // the header goes last, a journal without it is ignored
+#if defined (TARGET_MTS_MDOT_F411RE)
+    journal.Magic = 0;
+    if (!SaveFile(&_fs, journal_file, &journal, sizeof(journal))
+        || !AppendFile(&_fs, journal_file, &p, sizeof(p))
+        || !AppendFile(&_fs, journal_file, &n, sizeof(n))) {
+        return false;
+    }
+
+    mutex.lock();
+    int handle = SPIFFS_open(&_fs, journal_file, SPIFFS_RDWR, 0);
+    bool ret = handle >= 0;
+    if (ret) {
+        journal.Magic = PROVISIONING_JOURNAL_MAGIC;
+        ret = SPIFFS_write(&_fs, handle, &journal, sizeof(journal)) == sizeof(journal);
+        SPIFFS_close(&_fs, handle);
+    }
+    mutex.unlock();
+    return ret;
+#else
+    return xdot_eeprom_write_buf(PROVISIONING_ADDR + sizeof(journal), (uint8_t*)&p, sizeof(p)) == 0
+        && xdot_eeprom_write_buf(PROVISIONING_ADDR + sizeof(journal) + sizeof(p), (uint8_t*)&n, sizeof(n)) == 0
+        && xdot_eeprom_write_buf(PROVISIONING_ADDR, (uint8_t*)&journal, sizeof(journal)) == 0;
+#endif /* TARGET_MTS_MDOT_F411RE */
+}
+
+bool ConfigManager::ClearJournal() {
+    ScopedRomWriteLock make_rom_writable;
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+    DeleteFile(journal_file);
+    return true;
+#else
+    uint32_t magic = 0;
+    return xdot_eeprom_write_buf(PROVISIONING_ADDR, (uint8_t*)&magic, sizeof(magic)) == 0;
+#endif /* TARGET_MTS_MDOT_F411RE */
+}
+
+bool ConfigManager::RecoverProvisioning(DeviceConfig_t& dc) {
+    ProvisioningJournal_t journal;
+    bool ret;
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+    if (PVDO())
+        return false;
+
+    mutex.lock();
+    int handle = SPIFFS_open(&_fs, journal_file, SPIFFS_RDONLY, 0);
+    ret = handle >= 0
+        && SPIFFS_read(&_fs, handle, &journal, sizeof(journal)) == sizeof(journal)
+        && SPIFFS_read(&_fs, handle, &dc.provisioning, sizeof(dc.provisioning)) == sizeof(dc.provisioning)
+        && SPIFFS_read(&_fs, handle, &dc.settings, sizeof(dc.settings)) == sizeof(dc.settings);
+    if (handle >= 0)
+        SPIFFS_close(&_fs, handle);
+    mutex.unlock();
+
+    if (handle < 0)
+        return false;
+#else
+    ret = xdot_eeprom_read_buf(PROVISIONING_ADDR, (uint8_t*)&journal, sizeof(journal)) == 0;
+    if (!ret || journal.Magic != PROVISIONING_JOURNAL_MAGIC)
+        return false;
+    ret = xdot_eeprom_read_buf(PROVISIONING_ADDR + sizeof(journal), (uint8_t*)&dc.provisioning, sizeof(dc.provisioning)) == 0
+        && xdot_eeprom_read_buf(PROVISIONING_ADDR + sizeof(journal) + sizeof(dc.provisioning), (uint8_t*)&dc.settings, sizeof(dc.settings)) == 0;
+#endif /* TARGET_MTS_MDOT_F411RE */
+
+    ret = ret
+        && journal.Magic == PROVISIONING_JOURNAL_MAGIC
+        && journal.Length == sizeof(dc.provisioning) + sizeof(dc.settings)
+        && journal.Crc == crc16(&dc.settings, sizeof(dc.settings), crc16(&dc.provisioning, sizeof(dc.provisioning)));
+
+    if (!ret) {
+        // incomplete, the previous settings were never touched
+        printf("Discarding incomplete provisioning journal.\r\n");
+        ClearJournal();
+        return false;
+    }
+
+    printf("Completing interrupted provisioning.\r\n");
+    if (!SaveProtected(dc.provisioning) || !Save(dc.settings))
+        return false;
+
+    return ClearJournal();
+}
 
 bool ConfigManager::SaveSettings(ApplicationSettings_t& a) {
     bool ret;
@@ -506,24 +1077,13 @@ bool ConfigManager::AppendFile(spiffs *fs, const char* file, void* data, uint32_
         return false;
     }
 
-    if (handle) {
-        ret = SPIFFS_write(fs, handle, data, size);
-        if (ret < 0)
-            printf("SPIFFS_write failed %d", SPIFFS_errno(fs));
-
-        SPIFFS_close(fs, handle);
-    }
-
-    // read the current file contents
-    spiffs_stat stat;
-    memset(&stat, 0, sizeof(stat));
-    ret = SPIFFS_stat(fs, file, &stat);
-    if (ret)
-        printf("SPIFFS_stat failed %d", SPIFFS_errno(fs));
+    ret = SPIFFS_write(fs, handle, data, size);
+    if (ret < 0)
+        printf("SPIFFS_write failed %d", SPIFFS_errno(fs));
 
     SPIFFS_close(fs, handle);
     mutex.unlock();
-    return true;
+    return ret >= 0;
 }
 
 bool ConfigManager::SaveFile(spiffs *fs, const char* file, void* data, uint32_t size) {
@@ -594,7 +1154,7 @@ bool ConfigManager::SaveFile(spiffs *fs, const char* file, void* data, uint32_t
     return true;
 }
 
-bool ConfigManager::ReadFile(spiffs *fs, const char* file, void* dest, uint32_t size) {
+bool ConfigManager::ReadFile(spiffs *fs, const char* file, void* dest, uint32_t size, bool prefix) {
     if(PVDO())
         return false;
 
@@ -608,7 +1168,7 @@ bool ConfigManager::ReadFile(spiffs *fs, const char* file, void* dest, uint32_t
         mutex.unlock();
         return false;
     }
-    else if (stat.size != size) {
+    else if (stat.size != size && !prefix) {
         printf( "File from flash wrong size. Expected %lu - Actual %lu", size, stat.size);
         mutex.unlock();
         return false;
@@ -622,13 +1182,16 @@ bool ConfigManager::ReadFile(spiffs *fs, const char* file, void* dest, uint32_t
     }
 
     if (handle) {
+        uint32_t length = stat.size < size ? stat.size : size;
         uint32_t bytes_read = 0;
-        while (bytes_read < stat.size) {
-            uint32_t bytes_left = ((stat.size - bytes_read) < size ? (stat.size - bytes_read) : size);
 
-            ret = SPIFFS_read(fs, handle, dest, bytes_left);
-            if (ret < 0) {
+        memset((uint8_t*) dest + length, 0, size - length);
+
+        while (bytes_read < length) {
+            ret = SPIFFS_read(fs, handle, (uint8_t*) dest + bytes_read, length - bytes_read);
+            if (ret <= 0) {
                 printf("SPIFFS_read failed %d", SPIFFS_errno(fs));
+                SPIFFS_close(fs, handle);
                 mutex.unlock();
                 return false;
             }
@@ -645,6 +1208,8 @@ bool ConfigManager::ReadFile(spiffs *fs, const char* file, void* dest, uint32_t
 
 void ConfigManager::Load(DeviceConfig_t& dc) {
 
+    RecoverProvisioning(dc);
+
     // Need to load protected settings first so we can use as defaults for main cfg
 #if defined (TARGET_MTS_MDOT_F411RE)
     if (!ReadFile(&_fs, protected_file, &dc.provisioning, sizeof(dc.provisioning))) {
@@ -677,13 +1242,26 @@ void ConfigManager::Load(DeviceConfig_t& dc) {
     }
 
 #if defined (TARGET_MTS_MDOT_F411RE)
-    if (!ReadFile(&_fs, session_file, &dc.app_settings, sizeof(dc.app_settings))) {
+    // app settings gain fields over time, a file stored by an older build
+    // is read as far as it goes and the new fields default below
+    if (!ReadFile(&_fs, app_settings_file, &dc.app_settings, sizeof(dc.app_settings), true)
+        || dc.app_settings.TxInterval == 0) {
 #else
     if (xdot_eeprom_read_buf(USER_ADDR, (uint8_t*)&dc.app_settings, sizeof(dc.app_settings))) {
-        printf("Failed to read session from EEPROM.");
+        printf("Failed to read app settings from EEPROM.");
 #endif /* TARGET_MTS_MDOT_F411RE */
         printf("App Settings to defaults.");
         DefaultSettings(dc);
+    } else if (dc.app_settings.SampleInterval == 0 || dc.app_settings.SampleInterval == 0xFFFFFFFF) {
+        // stored before the sample interval existed
+        dc.app_settings.SampleInterval = dc.app_settings.TxInterval;
+    }
+
+    if (dc.app_settings.JoinBackoffMin == 0 || dc.app_settings.JoinBackoffMin == 0xFFFFFFFF
+        || dc.app_settings.TxBackoffMin == 0 || dc.app_settings.TxBackoffMin == 0xFFFFFFFF
+        || dc.app_settings.BackoffJitter > 100) {
+        // stored before retry backoff existed
+        DefaultBackoff(dc);
     }
 
 
@@ -693,10 +1271,20 @@ void ConfigManager::Load(DeviceConfig_t& dc) {
 void ConfigManager::DefaultSettings(DeviceConfig_t& dc) {
     dc.app_settings.DutyCycleEnabled = MBED_CONF_LORA_DUTY_CYCLE_ON;
     dc.app_settings.TxInterval = 10000;
+    dc.app_settings.SampleInterval = 10000;
+    DefaultBackoff(dc);
 }
 
-void ConfigManager::DefaultSession(DeviceConfig_t& dc) {
+void ConfigManager::DefaultBackoff(DeviceConfig_t& dc) {
+    dc.app_settings.JoinBackoffMin = 15000;
+    dc.app_settings.JoinBackoffMax = 3600000;
+    dc.app_settings.TxBackoffMin = 5000;
+    dc.app_settings.TxBackoffMax = 600000;
+    dc.app_settings.BackoffJitter = 50;
+}
 
+void ConfigManager::DefaultSession(DeviceConfig_t& dc) {
+    memset(&dc.session, 0, sizeof(dc.session));
 }
 
 void ConfigManager::DefaultProtected(DeviceConfig_t& dc) {
@@ -64,7 +64,61 @@ const uint8_t CURRENT_CONFIG_VERSION = 8;
 #define SETTINGS_ADDR       0x0000      // configuration is 1024 bytes (0x000-0x3FF)
 #define PROTECTED_ADDR      0x0400      // protected configuration is 256 bytes (0x400-0x4FF)
 #define SESSION_ADDR        0x0500      // session is 512 bytes (0x500-0x6FF)
-#define USER_ADDR           0x0800      // user space is 6*1024 bytes (0x800 - 0x1FFF)
+#define USER_ADDR           0x0800      // user space is 4*1024 bytes (0x800 - 0x17FF)
+#define PROVISIONING_ADDR   0x1800      // provisioning journal is 8+1280 bytes (0x1800 - 0x1D07)
+#endif /* TARGET_MTS_MDOT_F411RE */
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+// Streaming access to a user file. The descriptor is kept open between calls,
+// writes are staged until a full page is available and sequential reads are
+// served from a page sized read-ahead buffer.
+typedef struct {
+        file_record file;
+        uint8_t buffer[PAGE_SIZE];
+        uint16_t length;        // bytes held in buffer
+        uint16_t offset;        // read position within buffer
+        bool writing;           // buffer holds pending writes rather than read-ahead
+} user_stream;
+
+// Filesystem usage in pages, lookup pages are not counted
+typedef struct {
+        uint32_t PageSize;
+        uint32_t BlockSize;
+        uint32_t Blocks;
+        uint32_t FreeBlocks;
+        uint32_t Pages;
+        uint32_t UsedPages;
+        uint32_t DeletedPages;  // reclaimed by garbage collection
+} fs_stats;
+
+#define FLASH_BENCH_READ_SIZES 3
+
+// Raw SPI flash timings, measured on a block SPIFFS has not allocated
+typedef struct {
+        uint32_t Address;                               // block programmed and erased
+        uint16_t ReadSize[FLASH_BENCH_READ_SIZES];      // bytes per read
+        uint32_t ReadTime[FLASH_BENCH_READ_SIZES];      // us per read
+        uint16_t Pages;                                 // pages programmed
+        uint32_t ProgramMin;                            // us per page
+        uint32_t ProgramMax;
+        uint32_t ProgramTotal;
+        uint32_t EraseTime;                             // us for the block
+} flash_bench;
+
+// Time the SPI flash spent powered and in deep power down
+typedef struct {
+        bool Awake;
+        uint32_t Wakeups;
+        uint64_t AwakeTime;     // ms
+        uint64_t SleepTime;     // ms
+} flash_power;
+
+// Result of a filesystem consistency check
+typedef struct {
+        uint32_t Errors;
+        uint32_t Fixes;         // indexes or lookups repaired, bad pages and files deleted
+        uint32_t Duration;      // ms
+} fs_check;
 #endif /* TARGET_MTS_MDOT_F411RE */
 
 #define MULTICAST_SESSIONS 3
@@ -266,6 +320,13 @@ typedef struct {
 typedef struct {
         bool DutyCycleEnabled;
         uint32_t TxInterval;
+        uint32_t SampleInterval;
+        uint32_t JoinBackoffMin;        // ms before the first join retry
+        uint32_t JoinBackoffMax;        // cap of the doubling join retry delay
+        uint32_t TxBackoffMin;          // ms before retrying a failed uplink
+        uint32_t TxBackoffMax;          // cap of the doubling uplink retry delay
+        uint8_t BackoffJitter;          // percent of each retry delay that is randomized
+        uint32_t TimeEpoch;             // counts boots and 2^24 s of uptime, tags reading timestamps
 } ApplicationSettings_t;
 
 typedef struct {
@@ -275,6 +336,17 @@ typedef struct {
   ApplicationSettings_t app_settings;
 } DeviceConfig_t;
 
+#define PROVISIONING_JOURNAL_MAGIC 0x564f5250   // "PROV"
+
+// Header of a provisioning image, followed by ProtectedSettings_t and
+// NetworkSettings_t. The image is journaled first and copied to the regular
+// settings afterwards, so an interrupted save is completed on the next boot.
+typedef struct {
+        uint32_t Magic;
+        uint16_t Crc;           // CRC16 of the settings that follow
+        uint16_t Length;        // bytes that follow
+} ProvisioningJournal_t;
+
 
 class ConfigManager {
 
@@ -340,17 +412,47 @@ class ConfigManager {
         bool SaveSession(NetworkSession_t& s);
         bool SaveProtected(ProtectedSettings_t& p);
 
+        /**
+         * Save protected settings and settings together, either both are
+         * stored or, after a reset part way, both are on the next Load
+         */
+        bool SaveProvisioning(ProtectedSettings_t& p, NetworkSettings_t& n);
+
         void Mount();
         void Load(DeviceConfig_t& dc);
         void Default(DeviceConfig_t& dc);
         void DefaultSettings(DeviceConfig_t& dc);
+        void DefaultBackoff(DeviceConfig_t& dc);
         void DefaultSession(DeviceConfig_t& dc);
         void DefaultProtected(DeviceConfig_t& dc);
 
+        /**
+         * True if s holds an address and keys an ABP style restore can resume
+         */
+
+        /**
+         * Put the SPI flash in deep power down and release it. Every flash
+         * access wakes it on demand, so Sleep is safe at any time.
+         */
         void Sleep();
         void Wakeup();
 
 #if defined (TARGET_MTS_MDOT_F411RE)
+        /**
+         * Sleep if the flash was unused for idle_ms. Otherwise, or while
+         * another thread has the filesystem, remaining is the ms to try again
+         * after.
+         */
+        bool SleepIfIdle(uint32_t idle_ms, uint32_t& remaining);
+
+        /**
+         * Called when the flash leaves deep power down, from the thread that
+         * accesses it
+         */
+        void OnFlashWakeup(Callback<void()> wakeup);
+
+        void FlashPower(flash_power& power);
+
         void EnablePVD();
         bool PVDO();
 
@@ -358,6 +460,7 @@ class ConfigManager {
         bool SeekUserFile(file_record& file, size_t offset, int whence);
         int ReadUserFile(file_record& file, void* data, size_t length);
         int WriteUserFile(file_record& file, void* data, size_t length);
+        bool FlushUserFile(file_record& file);
         bool CloseUserFile(file_record& file);
         bool MoveUserFile(file_record& file, const char* new_name);
 
@@ -366,11 +469,49 @@ class ConfigManager {
         bool AppendUserFile(const char* file, void* data, uint32_t size);
         bool ReadUserFile(const char* file, void* data, uint32_t size);
         bool DeleteUserFile(const char* file);
+
+        /**
+         * True while a descriptor is open on the user file, e.g. the
+         * uplink queue log
+         */
+        bool UserFileOpen(const char* file);
         bool DeleteFile(const char* file);
 
         bool MoveUserFileToFirwareUpgrade(const char* file);
 
+        bool OpenUserStream(user_stream& stream, const char* file, int mode);
+        int WriteUserStream(user_stream& stream, const void* data, size_t length);
+        int ReadUserStream(user_stream& stream, void* data, size_t length);
+        bool FlushUserStream(user_stream& stream);
+        bool CloseUserStream(user_stream& stream);
+
         uint32_t UsedSpace();
+
+        /**
+         * Diagnostics over every file by its filesystem name, user files
+         * carry a "u_" prefix
+         */
+        void ListFiles(Callback<void(const struct spiffs_dirent&)> visit);
+        file_record OpenFile(const char* file, int mode);
+        bool FileSystemStats(fs_stats& stats);
+
+        /**
+         * Run the SPIFFS consistency check, progress gets the phase and
+         * 0-100 percent done
+         */
+        bool Check(fs_check& result, Callback<void(const char*, uint8_t)> progress);
+
+        /**
+         * Time raw flash reads, page programs and a block erase. Needs a
+         * block without any file pages, which is restored afterwards.
+         * The filesystem is locked throughout.
+         */
+        bool BenchmarkFlash(flash_bench& result);
+
+        /**
+         * Unmount and mount the filesystem, false if files are open
+         */
+        bool Remount(uint32_t& duration_ms);
 #endif /* TARGET_MTS_MDOT_F411RE */
 
     private:
@@ -389,14 +530,31 @@ class ConfigManager {
 
         bool AppendFile(spiffs *fs, const char* file, void* data, uint32_t size);
         bool SaveFile(spiffs *fs, const char* file, void* data, uint32_t size);
-        bool ReadFile(spiffs *fs, const char* file, void* dest, uint32_t size);
+        // with prefix a file of another size is accepted, the part of dest
+        // it does not cover is zeroed, for structs that gained fields
+        bool ReadFile(spiffs *fs, const char* file, void* dest, uint32_t size, bool prefix = false);
         bool MoveFile(spiffs *fs, const char* file, const char* new_name);
 
+        static void check_report(spiffs_check_type type, spiffs_check_report report, u32_t arg1, u32_t arg2);
+
         // glue code between SPI driver and filesystem
         static int spi_read(unsigned int addr, unsigned int size, unsigned char* data);
         static int spi_write(unsigned int addr, unsigned int size, unsigned char* data);
         static int spi_erase(unsigned int addr, unsigned int size);
 
+        // release from deep power down takes at most 30 us (tRES1)
+        static const uint32_t FlashWakeupTime = 30;
+
+        static void FlashState(bool asleep);
+        static void WakeFlash();
+
+        static bool _flash_asleep;
+        static uint32_t _flash_wakeups;
+        static uint64_t _flash_changed;         // ms, last power change
+        static uint64_t _flash_used;            // ms, last access
+        static uint64_t _flash_time[2];         // ms awake, asleep
+        static Callback<void()> _flash_wakeup;
+
         static u8_t spiffs_work_buf[PAGE_SIZE * 2];
         static u8_t spiffs_fds[32 * MAX_CONCURRENT_FDS];
         static u8_t spiffs_cache_buf[(PAGE_SIZE + 32) * 4];
@@ -408,9 +566,19 @@ class ConfigManager {
         static char file[];
         static char protected_file[];
         static char session_file[];
+        static char app_settings_file[];
+        static char journal_file[];
         static char user_dir[];
 #endif /* TARGET_MTS_MDOT_F411RE */
 
+        bool WriteJournal(ProtectedSettings_t& p, NetworkSettings_t& n);
+        bool ClearJournal();
+
+        /**
+         * Finish a provisioning save cut short by a reset, true if one was
+         */
+        bool RecoverProvisioning(DeviceConfig_t& dc);
+
 };
 
 #endif
@@ -0,0 +1,239 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "config_fields.h"
+#include "shell_parser.h"
+
+#define FIELD_ENTRY(name, section, type, member, count, min, max) \
+    { #name, section, type, sizeof(((DeviceConfig_t*) 0)->member) / (count), count, \
+      offsetof(DeviceConfig_t, member), (uint32_t) (min), (uint32_t) (max) },
+#define CONFIG_FIELD(name, section, type, member, min, max) \
+    FIELD_ENTRY(name, section, type, member, 1, min, max)
+#define CONFIG_ARRAY(name, section, type, member, min, max) \
+    FIELD_ENTRY(name, section, type, member, sizeof(((DeviceConfig_t*) 0)->member) / sizeof(((DeviceConfig_t*) 0)->member[0]), min, max)
+
+const config_field config_fields[FIELD_COUNT] = {
+#include "field_list.h"
+};
+
+#undef CONFIG_FIELD
+#undef CONFIG_ARRAY
+#undef FIELD_ENTRY
+
+MBED_STATIC_ASSERT(sizeof(DeviceConfig_t) <= UINT16_MAX, "field offsets are 16 bit");
+MBED_STATIC_ASSERT(sizeof(((DeviceConfig_t*) 0)->settings.Channels) <= FIELD_MAX_SIZE, "channels don't fit a field value");
+
+static uint8_t dirty;
+
+const config_field* find_field(const char* name) {
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        if (strcmp(config_fields[i].Name, name) == 0) {
+            return &config_fields[i];
+        }
+    }
+
+    return NULL;
+}
+
+const config_field* find_field_element(const char* name, uint8_t& element) {
+    const char* dot = strchr(name, '.');
+    size_t length = dot ? (size_t) (dot - name) : strlen(name);
+
+    element = FIELD_ALL;
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const config_field& field = config_fields[i];
+        if (strlen(field.Name) != length || strncmp(field.Name, name, length) != 0) {
+            continue;
+        }
+        if (dot == NULL) {
+            return &field;
+        }
+
+        uint32_t index = 0;
+        if (field.Count == 1 || !parse_uint(dot + 1, 0, field.Count - 1, index)) {
+            return NULL;
+        }
+        element = index;
+        return &field;
+    }
+
+    return NULL;
+}
+
+static bool parse_element(const config_field& field, const char* text, uint8_t* value) {
+    bool flag = false;
+    uint32_t number = 0;
+    int32_t signed_number = 0;
+
+    switch (field.Type) {
+        case FIELD_BOOL:
+            if (!parse_bool(text, flag)) {
+                return false;
+            }
+            number = flag;
+            break;
+        case FIELD_UINT:
+            if (!parse_uint(text, field.Min, field.Max, number)) {
+                return false;
+            }
+            break;
+        case FIELD_INT:
+            if (!parse_int(text, (int32_t) field.Min, (int32_t) field.Max, signed_number)) {
+                return false;
+            }
+            number = (uint32_t) signed_number;
+            break;
+        case FIELD_HEX:
+            return parse_hex(text, value, field.Size);
+        default:
+            return false;
+    }
+
+    // little endian, the low bytes hold the value
+    memcpy(value, &number, field.Size);
+    return true;
+}
+
+bool parse_field(const config_field& field, const char* text, uint8_t* value, uint8_t element) {
+    char number[12];
+
+    if (field.Size * field.Count > FIELD_MAX_SIZE || (element != FIELD_ALL && element >= field.Count)) {
+        return false;
+    }
+    if (field.Count == 1 || element != FIELD_ALL) {
+        return parse_element(field, text, value);
+    }
+
+    // every element has to be given
+    for (uint8_t i = 0; i < field.Count; i++) {
+        const char* end = strchr(text, ',');
+        size_t length = end ? (size_t) (end - text) : strlen(text);
+
+        if (length >= sizeof(number) || (end == NULL) != (i == field.Count - 1)) {
+            return false;
+        }
+        memcpy(number, text, length);
+        number[length] = 0;
+        if (!parse_element(field, number, value + i * field.Size)) {
+            return false;
+        }
+        text += length + 1;
+    }
+
+    return true;
+}
+
+uint16_t field_offset(const config_field& field, uint8_t element) {
+    return element == FIELD_ALL ? field.Offset : field.Offset + element * field.Size;
+}
+
+uint8_t field_size(const config_field& field, uint8_t element) {
+    return element == FIELD_ALL ? field.Size * field.Count : field.Size;
+}
+
+void print_field(const config_field& field, const DeviceConfig_t& dc, uint8_t element) {
+    const uint8_t* value = (const uint8_t*) &dc + field.Offset;
+    uint8_t count = field.Count;
+
+    if (element != FIELD_ALL) {
+        value += element * field.Size;
+        count = 1;
+    }
+
+    if (field.Type == FIELD_HEX) {
+        for (uint8_t i = 0; i < field.Size; i++) {
+            printf("%02x", value[i]);
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++, value += field.Size) {
+        uint32_t number = 0;
+        memcpy(&number, value, field.Size);
+
+        if (field.Type == FIELD_INT && field.Size < sizeof(number)
+            && (number & (1UL << (8 * field.Size - 1)))) {
+            // sign extend
+            number |= ~0UL << (8 * field.Size);
+        }
+
+        if (field.Type == FIELD_INT) {
+            printf("%s%ld", i ? "," : "", (long) (int32_t) number);
+        } else {
+            printf("%s%lu", i ? "," : "", (unsigned long) number);
+        }
+    }
+}
+
+void print_field_range(const config_field& field) {
+    switch (field.Type) {
+        case FIELD_BOOL:
+            printf("0:disabled, 1:enabled");
+            break;
+        case FIELD_UINT:
+            printf("%lu-%lu", (unsigned long) field.Min, (unsigned long) field.Max);
+            break;
+        case FIELD_INT:
+            printf("%ld to %ld", (long) (int32_t) field.Min, (long) (int32_t) field.Max);
+            break;
+        case FIELD_HEX:
+            printf("%u hex digits", 2 * field.Size);
+            break;
+    }
+
+    if (field.Count > 1) {
+        printf(", %u comma separated, or one as %s.0-%u", field.Count, field.Name, field.Count - 1);
+    }
+}
+
+uint8_t dirty_sections() {
+    return dirty;
+}
+
+void mark_dirty(uint8_t sections) {
+    CriticalSectionLock lock;
+    dirty |= sections;
+}
+
+void clear_dirty(uint8_t sections) {
+    CriticalSectionLock lock;
+    dirty &= ~sections;
+}
+
+const char* section_name(uint8_t section) {
+    switch (section) {
+        case SECTION_PROTECTED:
+            return "protected";
+        case SECTION_NETWORK:
+            return "network";
+        case SECTION_APP:
+            return "app";
+        default:
+            return "";
+    }
+}
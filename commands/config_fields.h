@@ -0,0 +1,128 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_CONFIG_FIELDS__
+#define __MTS_CONFIG_FIELDS__
+
+#include "mbed.h"
+#include "config.h"
+
+/**
+ * Registry of the DeviceConfig_t fields the shell can read and write, built
+ * from field_list.h. Each field knows its place in DeviceConfig_t, its type,
+ * its range and the section that has to be saved once it changes.
+ */
+
+enum config_section {
+    SECTION_PROTECTED = 0x01,   // ProtectedSettings_t, saved by savep
+    SECTION_NETWORK = 0x02,     // NetworkSettings_t
+    SECTION_APP = 0x04          // ApplicationSettings_t
+};
+
+enum field_type {
+    FIELD_BOOL,
+    FIELD_UINT,
+    FIELD_INT,
+    FIELD_HEX                   // byte array, 2 digits per byte
+};
+
+enum config_field_id {
+#define CONFIG_FIELD(name, section, type, member, min, max) FIELD_##name,
+#define CONFIG_ARRAY(name, section, type, member, min, max) FIELD_##name,
+#include "field_list.h"
+#undef CONFIG_FIELD
+#undef CONFIG_ARRAY
+    FIELD_COUNT
+};
+
+typedef struct {
+        const char* Name;
+        uint8_t Section;
+        uint8_t Type;
+        uint8_t Size;           // bytes per element
+        uint8_t Count;          // elements, 1 unless an array
+        uint16_t Offset;        // in DeviceConfig_t
+        uint32_t Min;
+        uint32_t Max;
+} config_field;
+
+// largest value of a field, the channel list
+#define FIELD_MAX_SIZE 64
+
+// element index naming the whole field rather than one array element
+#define FIELD_ALL 0xff
+
+extern const config_field config_fields[FIELD_COUNT];
+
+/**
+ * Field by name, NULL if there is none
+ */
+const config_field* find_field(const char* name);
+
+/**
+ * Field by name, which may pick one array element by its index, e.g.
+ * channels.3. element is set to the index, or FIELD_ALL when the name has
+ * none. NULL if there is no such field or element.
+ */
+const config_field* find_field_element(const char* name, uint8_t& element);
+
+/**
+ * Validate text as a value of field, arrays take comma separated elements
+ * unless a single element is given. On success value holds the bytes of the
+ * field or element, nothing is stored yet.
+ */
+bool parse_field(const config_field& field, const char* text, uint8_t* value, uint8_t element = FIELD_ALL);
+
+/**
+ * Offset in DeviceConfig_t and size of a value from parse_field. The shell
+ * hands it to the application thread to store, as the stack reads the
+ * configuration there.
+ */
+uint16_t field_offset(const config_field& field, uint8_t element = FIELD_ALL);
+uint8_t field_size(const config_field& field, uint8_t element = FIELD_ALL);
+
+/**
+ * Print the value of field or one of its elements, without line ending
+ */
+void print_field(const config_field& field, const DeviceConfig_t& dc, uint8_t element = FIELD_ALL);
+
+/**
+ * Print the accepted values of field, without line ending
+ */
+void print_field_range(const config_field& field);
+
+/**
+ * Sections changed since they were last saved
+ */
+uint8_t dirty_sections();
+void mark_dirty(uint8_t sections);
+void clear_dirty(uint8_t sections);
+
+const char* section_name(uint8_t section);
+
+#endif
@@ -0,0 +1,83 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+/**
+ * Configuration fields reachable from the shell, one entry per field:
+ *
+ *   CONFIG_FIELD(name, section, type, member, min, max)
+ *       member of DeviceConfig_t, FIELD_HEX members are byte arrays
+ *
+ *   CONFIG_ARRAY(name, section, type, member, min, max)
+ *       array of numbers, every element is validated against min and max
+ *
+ * min and max are cast to int32_t for FIELD_INT. The section is the part of
+ * the configuration saved when the field changes.
+ */
+
+CONFIG_FIELD(frequencyband, SECTION_PROTECTED, FIELD_UINT, provisioning.FrequencyBand, 0, 255)
+CONFIG_FIELD(deveui, SECTION_PROTECTED, FIELD_HEX, provisioning.DeviceEUI, 0, 0)
+
+CONFIG_FIELD(appeui, SECTION_NETWORK, FIELD_HEX, settings.AppEUI, 0, 0)
+CONFIG_FIELD(appkey, SECTION_NETWORK, FIELD_HEX, settings.AppKey, 0, 0)
+CONFIG_FIELD(retries, SECTION_NETWORK, FIELD_UINT, settings.ACKAttempts, 0, 8)
+CONFIG_FIELD(joinretries, SECTION_NETWORK, FIELD_UINT, settings.JoinRetries, 0, 255)
+CONFIG_FIELD(adr, SECTION_NETWORK, FIELD_BOOL, settings.EnableADR, 0, 1)
+CONFIG_FIELD(datarate, SECTION_NETWORK, FIELD_UINT, settings.TxDataRate, 0, 15)
+CONFIG_FIELD(txpower, SECTION_NETWORK, FIELD_UINT, settings.TxPower, 0, 30)
+CONFIG_FIELD(antennagain, SECTION_NETWORK, FIELD_INT, settings.AntennaGain, -128, 127)
+CONFIG_FIELD(subband, SECTION_NETWORK, FIELD_UINT, settings.FrequencySubBand, 0, 8)
+CONFIG_FIELD(publicnetwork, SECTION_NETWORK, FIELD_BOOL, settings.PublicNetwork, 0, 1)
+CONFIG_FIELD(linkcheckcount, SECTION_NETWORK, FIELD_UINT, settings.LinkCheckCount, 0, 255)
+CONFIG_FIELD(linkcheckthreshold, SECTION_NETWORK, FIELD_UINT, settings.LinkCheckThreshold, 0, 255)
+CONFIG_FIELD(joindelay, SECTION_NETWORK, FIELD_UINT, settings.JoinDelay, 1, 15)
+CONFIG_FIELD(rxdelay, SECTION_NETWORK, FIELD_UINT, settings.RxDelay, 1, 15)
+CONFIG_FIELD(port, SECTION_NETWORK, FIELD_UINT, settings.Port, 1, 223)
+CONFIG_FIELD(repeat, SECTION_NETWORK, FIELD_UINT, settings.Repeat, 0, 15)
+CONFIG_FIELD(rx2datarate, SECTION_NETWORK, FIELD_UINT, settings.Rx2Datarate, 0, 15)
+CONFIG_FIELD(joinrx1droffset, SECTION_NETWORK, FIELD_UINT, settings.JoinRx1DatarateOffset, 0, 7)
+CONFIG_FIELD(joinrx2datarate, SECTION_NETWORK, FIELD_UINT, settings.JoinRx2DatarateIndex, 0, 15)
+CONFIG_FIELD(joinrx2frequency, SECTION_NETWORK, FIELD_UINT, settings.JoinRx2Frequency, 0, 1000000000)
+CONFIG_ARRAY(channels, SECTION_NETWORK, FIELD_UINT, settings.Channels, 0, 1000000000)
+CONFIG_FIELD(maxeirp, SECTION_NETWORK, FIELD_UINT, settings.MaxEIRP, 0, 36)
+CONFIG_FIELD(uldwelltime, SECTION_NETWORK, FIELD_BOOL, settings.UlDwellTime, 0, 1)
+CONFIG_FIELD(dldwelltime, SECTION_NETWORK, FIELD_BOOL, settings.DlDwellTime, 0, 1)
+CONFIG_FIELD(lbtthreshold, SECTION_NETWORK, FIELD_INT, settings.lbtThreshold, -128, 0)
+CONFIG_FIELD(lbttime, SECTION_NETWORK, FIELD_UINT, settings.lbtTimeUs, 0, 65535)
+CONFIG_FIELD(pingperiodicity, SECTION_NETWORK, FIELD_UINT, settings.PingPeriodicity, 0, 7)
+CONFIG_FIELD(txfrequencyoffset, SECTION_NETWORK, FIELD_INT, settings.TxFrequencyOffset, -1000000, 1000000)
+CONFIG_FIELD(adracklimit, SECTION_NETWORK, FIELD_UINT, settings.AdrAckLimit, 1, 32768)
+CONFIG_FIELD(adrackdelay, SECTION_NETWORK, FIELD_UINT, settings.AdrAckDelay, 1, 32768)
+
+CONFIG_FIELD(dutycycle, SECTION_APP, FIELD_BOOL, app_settings.DutyCycleEnabled, 0, 1)
+CONFIG_FIELD(txinterval, SECTION_APP, FIELD_UINT, app_settings.TxInterval, 1000, 86400000)
+CONFIG_FIELD(sampleinterval, SECTION_APP, FIELD_UINT, app_settings.SampleInterval, 100, 86400000)
+CONFIG_FIELD(joinbackoffmin, SECTION_APP, FIELD_UINT, app_settings.JoinBackoffMin, 1, 0xFFFFFFFF)
+CONFIG_FIELD(joinbackoffmax, SECTION_APP, FIELD_UINT, app_settings.JoinBackoffMax, 1, 0xFFFFFFFF)
+CONFIG_FIELD(txbackoffmin, SECTION_APP, FIELD_UINT, app_settings.TxBackoffMin, 1, 0xFFFFFFFF)
+CONFIG_FIELD(txbackoffmax, SECTION_APP, FIELD_UINT, app_settings.TxBackoffMax, 1, 0xFFFFFFFF)
+CONFIG_FIELD(jitter, SECTION_APP, FIELD_UINT, app_settings.BackoffJitter, 0, 100)
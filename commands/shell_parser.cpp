@@ -0,0 +1,132 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "shell_parser.h"
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+bool parse_uint(const char* text, uint32_t min, uint32_t max, uint32_t& value) {
+    uint32_t base = 10;
+    uint64_t result = 0;
+
+    if (text[0] == '0' && lower(text[1]) == 'x') {
+        base = 16;
+        text += 2;
+    }
+    if (*text == 0) {
+        return false;
+    }
+
+    for (; *text; text++) {
+        int digit = hex_digit(*text);
+        if (digit < 0 || (uint32_t) digit >= base) {
+            return false;
+        }
+        result = result * base + digit;
+        if (result > max) {
+            return false;
+        }
+    }
+
+    if (result < min) {
+        return false;
+    }
+
+    value = (uint32_t) result;
+    return true;
+}
+
+bool parse_int(const char* text, int32_t min, int32_t max, int32_t& value) {
+    uint32_t magnitude = 0;
+
+    if (text[0] == '-') {
+        // magnitude of INT32_MIN still fits
+        if (min >= 0 || !parse_uint(text + 1, 0, 0 - (uint32_t) min, magnitude)) {
+            return false;
+        }
+        value = (int32_t) (0 - magnitude);
+        return value <= max;
+    }
+
+    if (max < 0 || !parse_uint(text, 0, max, magnitude)) {
+        return false;
+    }
+    value = (int32_t) magnitude;
+    return value >= min;
+}
+
+bool parse_hex(const char* text, uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        int high = hex_digit(text[2 * i]);
+        int low = high < 0 ? -1 : hex_digit(text[2 * i + 1]);
+        if (low < 0) {
+            return false;
+        }
+        data[i] = (high << 4) | low;
+    }
+
+    return text[2 * length] == 0;
+}
+
+bool parse_bool(const char* text, bool& value) {
+    if ((text[0] != '0' && text[0] != '1') || text[1] != 0) {
+        return false;
+    }
+
+    value = text[0] == '1';
+    return true;
+}
+
+int parse_choice(const char* text, const char* const* choices, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        const char* a = text;
+        const char* b = choices[i];
+
+        while (*a && lower(*a) == lower(*b)) {
+            a++;
+            b++;
+        }
+        if (*a == 0 && *b == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,65 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_SHELL_PARSER__
+#define __MTS_SHELL_PARSER__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Argument parsing shared by all shell commands. Each parser takes the
+ * whole argument, trailing characters make it invalid.
+ */
+
+/**
+ * Decimal, or hex with a 0x prefix, within min and max
+ */
+bool parse_uint(const char* text, uint32_t min, uint32_t max, uint32_t& value);
+
+/**
+ * Decimal with an optional minus sign, or hex with a 0x prefix, within min and max
+ */
+bool parse_int(const char* text, int32_t min, int32_t max, int32_t& value);
+
+/**
+ * Exactly 2 * length hex digits, most significant byte first
+ */
+bool parse_hex(const char* text, uint8_t* data, size_t length);
+
+/**
+ * 0 or 1
+ */
+bool parse_bool(const char* text, bool& value);
+
+/**
+ * Index of text in choices, case insensitive, -1 if not there
+ */
+int parse_choice(const char* text, const char* const* choices, uint8_t count);
+
+#endif
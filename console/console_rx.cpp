@@ -0,0 +1,124 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "console_rx.h"
+
+ConsoleRx::ConsoleRx(RawSerial& serial, PinName wake)
+:   _serial(serial),
+    _wake(NULL),
+    _listening(false),
+    _peak(0),
+    _overflows(0)
+{
+    if (wake != NC) {
+        _wake = new InterruptIn(wake);
+    }
+}
+
+void ConsoleRx::Start() {
+    Listen();
+}
+
+void ConsoleRx::Listen() {
+    _listening = true;
+    _serial.attach(callback(this, &ConsoleRx::RxIrq), SerialBase::RxIrq);
+
+    if (_wake) {
+        _wake->fall(Callback<void()>());
+        _idle.attach_us(callback(this, &ConsoleRx::Idle), MBED_CONF_APP_CONSOLE_IDLE_TIMEOUT * 1000);
+    }
+}
+
+void ConsoleRx::Idle() {
+    // detaching releases the deep sleep lock the RX interrupt holds
+    _serial.attach(Callback<void()>(), SerialBase::RxIrq);
+    _listening = false;
+    _wake->fall(callback(this, &ConsoleRx::Listen));
+}
+
+void ConsoleRx::RxIrq() {
+    while (_serial.readable()) {
+        uint8_t c = _serial.getc();
+        if (!_ring.Push(c)) {
+            _overflows++;
+        }
+    }
+
+    if (_ring.Count() > _peak) {
+        _peak = _ring.Count();
+    }
+
+    if (_wake) {
+        _idle.attach_us(callback(this, &ConsoleRx::Idle), MBED_CONF_APP_CONSOLE_IDLE_TIMEOUT * 1000);
+    }
+
+    _flags.set(DataFlag);
+}
+
+uint32_t ConsoleRx::Read(uint8_t* buffer, uint32_t length, uint32_t timeout) {
+    uint32_t count = 0;
+
+    // the flag is set after every push, so checking the ring first can't
+    // miss a byte that arrives before the wait
+    while (_ring.Count() == 0) {
+        if (_flags.wait_any(DataFlag, timeout) & osFlagsError) {
+            return 0;
+        }
+    }
+
+    while (count < length && _ring.Pop(buffer[count])) {
+        count++;
+    }
+
+    return count;
+}
+
+void ConsoleRx::Flush() {
+    _ring.Clear();
+}
+
+uint32_t ConsoleRx::Size() const {
+    return _ring.Capacity();
+}
+
+uint32_t ConsoleRx::Peak() const {
+    return _peak;
+}
+
+uint32_t ConsoleRx::Overflows() const {
+    return _overflows;
+}
+
+void ConsoleRx::ResetCounters() {
+    _peak = _ring.Count();
+    _overflows = 0;
+}
+
+bool ConsoleRx::Listening() const {
+    return _listening;
+}
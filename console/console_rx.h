@@ -0,0 +1,107 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_CONSOLE_RX__
+#define __MTS_CONSOLE_RX__
+
+#include "mbed.h"
+#include "spsc_ring.h"
+
+/**
+ * Console input fed by the serial RX interrupt into a ring of
+ * console-rx-buffer-size bytes. Readers block on an event flag, so the CPU
+ * sleeps until a character arrives, and take everything received so far in
+ * one batch. Bytes that arrive while the ring is full are dropped and
+ * counted.
+ *
+ * An attached RX interrupt keeps the device out of deep sleep. With a wake
+ * pin the console stops listening after console-idle-timeout ms without
+ * input and a falling edge on the pin starts it again. Tie the pin to RX and
+ * the first character wakes the console, it is lost.
+ */
+class ConsoleRx {
+
+    public:
+
+        ConsoleRx(RawSerial& serial, PinName wake = NC);
+
+        /**
+         * Start receiving, attaches the RX interrupt
+         */
+        void Start();
+
+        /**
+         * Copy up to length received bytes into buffer, waiting up to
+         * timeout ms for the first one. Returns the number of bytes copied,
+         * 0 on timeout.
+         */
+        uint32_t Read(uint8_t* buffer, uint32_t length, uint32_t timeout = osWaitForever);
+
+        /**
+         * Drop everything received so far
+         */
+        void Flush();
+
+        uint32_t Size() const;
+
+        /**
+         * Most bytes ever waiting in the ring
+         */
+        uint32_t Peak() const;
+
+        /**
+         * Bytes dropped because the ring was full
+         */
+        uint32_t Overflows() const;
+
+        void ResetCounters();
+
+        /**
+         * True while the RX interrupt is attached
+         */
+        bool Listening() const;
+
+    private:
+
+        static const uint32_t DataFlag = 0x1;
+
+        void RxIrq();
+        void Listen();
+        void Idle();
+
+        RawSerial& _serial;
+        InterruptIn* _wake;
+        Timeout _idle;
+        volatile bool _listening;
+        SpscRing<uint8_t, MBED_CONF_APP_CONSOLE_RX_BUFFER_SIZE> _ring;
+        EventFlags _flags;
+        volatile uint32_t _peak;
+        volatile uint32_t _overflows;
+};
+
+#endif
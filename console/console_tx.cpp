@@ -0,0 +1,174 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "console_tx.h"
+
+// bytes pushed per critical section, bounds the interrupt latency added
+#define WRITE_CHUNK     32
+
+ConsoleTx::ConsoleTx(RawSerial& serial, DropPolicy policy)
+:   _serial(serial),
+    _policy(policy),
+    _armed(false),
+    _peak(0),
+    _dropped(0)
+{
+}
+
+ssize_t ConsoleTx::write(const void* buffer, size_t size) {
+    const uint8_t* data = (const uint8_t*) buffer;
+    bool may_wait = !core_util_is_isr_active() && osThreadGetPriority(osThreadGetId()) <= osPriorityLow;
+    size_t written = 0;
+
+    while (written < size) {
+        {
+            // the ring has a single producer, writers from several threads
+            // and the interrupt are serialized here
+            CriticalSectionLock lock;
+            size_t end = written + WRITE_CHUNK < size ? written + WRITE_CHUNK : size;
+
+            while (written < end) {
+                if (!_ring.Push(data[written])) {
+                    if (may_wait) {
+                        break;
+                    }
+                    if (_policy == DROP_OLDEST) {
+                        // the TX interrupt can't run inside the critical section
+                        uint8_t oldest;
+                        _ring.Pop(oldest);
+                        _ring.Push(data[written]);
+                    }
+                    _dropped++;
+                }
+                written++;
+            }
+
+            if (_ring.Count() > _peak) {
+                _peak = _ring.Count();
+            }
+
+            if (!_armed && _ring.Count() > 0) {
+                _armed = true;
+                _serial.attach(callback(this, &ConsoleTx::TxIrq), SerialBase::TxIrq);
+            }
+        }
+
+        if (written < size && may_wait && _ring.Count() == _ring.Capacity()) {
+            ThisThread::sleep_for(1);
+        }
+    }
+
+    return size;
+}
+
+bool ConsoleTx::TryWrite(const uint8_t* data, uint32_t length) {
+    CriticalSectionLock lock;
+
+    if (_ring.Capacity() - _ring.Count() < length) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < length; i++) {
+        _ring.Push(data[i]);
+    }
+
+    if (_ring.Count() > _peak) {
+        _peak = _ring.Count();
+    }
+
+    if (!_armed) {
+        _armed = true;
+        _serial.attach(callback(this, &ConsoleTx::TxIrq), SerialBase::TxIrq);
+    }
+    return true;
+}
+
+void ConsoleTx::TxIrq() {
+    uint8_t c;
+
+    while (_serial.writeable()) {
+        if (!_ring.Pop(c)) {
+            // nothing left, stop the TX empty interrupt and let the device sleep
+            _serial.attach(Callback<void()>(), SerialBase::TxIrq);
+            _armed = false;
+            return;
+        }
+        _serial.putc(c);
+    }
+}
+
+ssize_t ConsoleTx::read(void* buffer, size_t size) {
+    // console input is read through ConsoleRx
+    return -EBADF;
+}
+
+off_t ConsoleTx::seek(off_t offset, int whence) {
+    return -ESPIPE;
+}
+
+int ConsoleTx::close() {
+    return 0;
+}
+
+int ConsoleTx::isatty() {
+    return 1;
+}
+
+int ConsoleTx::sync() {
+    return Flush(1000) ? 0 : -EAGAIN;
+}
+
+bool ConsoleTx::Flush(uint32_t timeout) {
+    Timer tm;
+    tm.start();
+
+    while (_ring.Count() > 0) {
+        if ((uint32_t) tm.read_ms() >= timeout) {
+            return false;
+        }
+        ThisThread::sleep_for(1);
+    }
+    return true;
+}
+
+uint32_t ConsoleTx::Size() const {
+    return _ring.Capacity();
+}
+
+uint32_t ConsoleTx::Peak() const {
+    return _peak;
+}
+
+uint32_t ConsoleTx::Dropped() const {
+    return _dropped;
+}
+
+void ConsoleTx::ResetCounters() {
+    _peak = _ring.Count();
+    _dropped = 0;
+}
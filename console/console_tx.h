@@ -0,0 +1,98 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_CONSOLE_TX__
+#define __MTS_CONSOLE_TX__
+
+#include "mbed.h"
+#include "spsc_ring.h"
+
+/**
+ * Console output through a ring of console-tx-buffer-size bytes drained by
+ * the serial TX interrupt. Installed as the stdio console, so printf
+ * returns as soon as the text is buffered instead of waiting for the UART.
+ *
+ * When the ring is full, threads at osPriorityLow and below, i.e. the
+ * shell, wait for room. Everything else drops text following the drop
+ * policy and counts the dropped bytes, so logging never stalls the stack.
+ */
+class ConsoleTx : public FileHandle {
+
+    public:
+
+        enum DropPolicy {
+            DROP_NEWEST,
+            DROP_OLDEST
+        };
+
+        ConsoleTx(RawSerial& serial, DropPolicy policy);
+
+        virtual ssize_t write(const void* buffer, size_t size);
+        virtual ssize_t read(void* buffer, size_t size);
+        virtual off_t seek(off_t offset, int whence = SEEK_SET);
+        virtual int close();
+        virtual int isatty();
+
+        /**
+         * Buffer all of data or nothing, never waits or drops
+         */
+        bool TryWrite(const uint8_t* data, uint32_t length);
+
+        /**
+         * Wait up to timeout ms for everything buffered to be sent
+         */
+        virtual int sync();
+        bool Flush(uint32_t timeout);
+
+        uint32_t Size() const;
+
+        /**
+         * Most bytes ever waiting in the ring
+         */
+        uint32_t Peak() const;
+
+        /**
+         * Bytes dropped because the ring was full
+         */
+        uint32_t Dropped() const;
+
+        void ResetCounters();
+
+    private:
+
+        void TxIrq();
+
+        RawSerial& _serial;
+        SpscRing<uint8_t, MBED_CONF_APP_CONSOLE_TX_BUFFER_SIZE> _ring;
+        DropPolicy _policy;
+        volatile bool _armed;           // TX interrupt attached
+        volatile uint32_t _peak;
+        volatile uint32_t _dropped;
+};
+
+#endif
@@ -0,0 +1,73 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "shell_mailbox.h"
+
+ShellMailbox::ShellMailbox()
+{
+}
+
+void ShellMailbox::SetNotify(Callback<void()> notify) {
+    _notify = notify;
+}
+
+bool ShellMailbox::Call(const shell_request& request, shell_response& response, uint32_t timeout) {
+    // drop answers to requests that timed out earlier
+    _responses.Clear();
+    _flags.clear(ResponseFlag);
+
+    if (!_requests.Push(request)) {
+        return false;
+    }
+
+    if (_notify) {
+        _notify();
+    }
+
+    while (true) {
+        if (_responses.Pop(response)) {
+            if (response.Command == request.Command) {
+                return true;
+            }
+            continue;
+        }
+
+        if (_flags.wait_any(ResponseFlag, timeout) & osFlagsError) {
+            return false;
+        }
+    }
+}
+
+bool ShellMailbox::Take(shell_request& request) {
+    return _requests.Pop(request);
+}
+
+void ShellMailbox::Reply(const shell_response& response) {
+    _responses.Push(response);
+    _flags.set(ResponseFlag);
+}
@@ -0,0 +1,103 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_SHELL_MAILBOX__
+#define __MTS_SHELL_MAILBOX__
+
+#include "mbed.h"
+#include "spsc_ring.h"
+
+// a config write of the channel list, the largest field
+#define MAILBOX_DATA_SIZE   68
+
+typedef struct {
+        uint8_t Command;
+        uint8_t Length;
+        uint8_t Data[MAILBOX_DATA_SIZE];
+} shell_request;
+
+typedef struct {
+        uint8_t Command;
+        int8_t Status;          // 0 on success
+        uint32_t Values[5];
+} shell_response;
+
+/**
+ * Passes commands from the shell thread to the application thread, which
+ * owns the stack and the uplink queue, and their results back. Both
+ * directions are lock free rings, the shell blocks on an event flag while
+ * the application only ever posts.
+ */
+class ShellMailbox {
+
+    public:
+
+        enum Command {
+            RUN,                // leave boot command mode and start the stack
+            STATUS,             // connected, tx pending, next uplink in ms, join attempts, tx attempts
+            QUEUE_STATUS,       // pending, capacity, dropped, drop oldest
+            QUEUE_CLEAR,
+            SEND_NOW,
+            CONFIG_WRITE        // offset in DeviceConfig_t (2 bytes), section, value
+        };
+
+        ShellMailbox();
+
+        /**
+         * Called from the shell thread after a request was posted, e.g. to
+         * queue the application side handler on its event queue
+         */
+        void SetNotify(Callback<void()> notify);
+
+        /**
+         * Shell side, post request and wait up to timeout ms for its
+         * response. Returns false if the application did not answer.
+         */
+        bool Call(const shell_request& request, shell_response& response, uint32_t timeout = 5000);
+
+        /**
+         * Application side, fetch the next pending request
+         */
+        bool Take(shell_request& request);
+
+        /**
+         * Application side, answer the request last taken
+         */
+        void Reply(const shell_response& response);
+
+    private:
+
+        static const uint32_t ResponseFlag = 0x1;
+
+        SpscRing<shell_request, 4> _requests;
+        SpscRing<shell_response, 4> _responses;
+        EventFlags _flags;
+        Callback<void()> _notify;
+};
+
+#endif
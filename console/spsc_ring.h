@@ -0,0 +1,110 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_SPSC_RING__
+#define __MTS_SPSC_RING__
+
+#include "mbed.h"
+
+/**
+ * Lock free ring of N items (a power of two) for exactly one producer and
+ * one consumer, which may be threads or interrupt handlers. The producer
+ * only writes _head and the consumer only writes _tail, the free running
+ * indices wrap naturally.
+ */
+template <typename T, uint32_t N>
+class SpscRing {
+
+    public:
+
+        SpscRing()
+        :   _head(0),
+            _tail(0)
+        {
+        }
+
+        /**
+         * Producer side, returns false if the ring is full
+         */
+        bool Push(const T& item) {
+            uint32_t head = _head;
+
+            if (head - _tail == N) {
+                return false;
+            }
+
+            _items[head & (N - 1)] = item;
+            // the item must be visible before the consumer sees the new head
+            __DMB();
+            _head = head + 1;
+            return true;
+        }
+
+        /**
+         * Consumer side, returns false if the ring is empty
+         */
+        bool Pop(T& item) {
+            uint32_t tail = _tail;
+
+            if (_head == tail) {
+                return false;
+            }
+
+            __DMB();
+            item = _items[tail & (N - 1)];
+            // the slot must be read before the producer may reuse it
+            __DMB();
+            _tail = tail + 1;
+            return true;
+        }
+
+        /**
+         * Consumer side, drop everything queued
+         */
+        void Clear() {
+            _tail = _head;
+        }
+
+        uint32_t Count() const {
+            return _head - _tail;
+        }
+
+        uint32_t Capacity() const {
+            return N;
+        }
+
+    private:
+
+        MBED_STRUCT_STATIC_ASSERT((N & (N - 1)) == 0, "ring size must be a power of two");
+
+        T _items[N];
+        volatile uint32_t _head;
+        volatile uint32_t _tail;
+};
+
+#endif
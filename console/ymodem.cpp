@@ -0,0 +1,263 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "ymodem.h"
+#include "crc16.h"
+
+YmodemReceiver::YmodemReceiver(ConsoleRx& rx, ConsoleTx& tx)
+:   _rx(rx),
+    _tx(tx),
+    _size(0),
+    _received(0),
+    _started(0),
+    _duration(0)
+{
+    _name[0] = 0;
+}
+
+YmodemReceiver::Result YmodemReceiver::Receive(Callback<bool(const uint8_t*, uint32_t)> sink) {
+    bool header = true;         // waiting for block 0 with name and size
+    bool ending = false;        // file done, waiting for the empty header ending the batch
+    uint8_t expected = 0;
+    uint8_t eots = 0;
+    uint32_t errors = 0;
+
+    _name[0] = 0;
+    _size = 0;
+    _received = 0;
+    _duration = 0;
+
+    _rx.Flush();
+    Put(CRC);
+
+    while (true) {
+        int length = ReadPacket();
+
+        switch (length) {
+            case PACKET_TIMEOUT:
+                // the sender may not be started yet, keep asking for a while
+                if (++errors > (header ? StartAttempts : MaxErrors)) {
+                    Cancel();
+                    return TIMEOUT;
+                }
+                Put(header || ending ? CRC : NAK);
+                continue;
+
+            case PACKET_CANCEL:
+                return CANCELLED;
+
+            case PACKET_CORRUPT:
+                if (++errors > MaxErrors) {
+                    Cancel();
+                    return PROTOCOL_ERROR;
+                }
+                Purge();
+                Put(NAK);
+                continue;
+
+            case PACKET_EOT:
+                if (ending) {
+                    // our ACK got lost
+                    Put(ACK);
+                } else if (!header && ++eots == 1) {
+                    // a single EOT may be line noise, the sender repeats it
+                    Put(NAK);
+                } else if (!header) {
+                    Put(ACK);
+                    Put(CRC);
+                    ending = true;
+                    errors = 0;
+                }
+                continue;
+        }
+
+        uint8_t block = _packet[0];
+
+        if (header || ending) {
+            if (block != 0) {
+                Put(NAK);
+                continue;
+            }
+            Put(ACK);
+
+            if (ending) {
+                if (_packet[2] != 0) {
+                    // another file in the batch
+                    Cancel();
+                }
+                _duration = Kernel::get_ms_count() - _started;
+                return DONE;
+            }
+
+            if (!ParseHeader()) {
+                return NO_FILE;
+            }
+            _started = Kernel::get_ms_count();
+            Put(CRC);
+            header = false;
+            expected = 1;
+            errors = 0;
+            continue;
+        }
+
+        if (block == (uint8_t) (expected - 1)) {
+            // repeated after a lost ACK
+            Put(ACK);
+            continue;
+        }
+        if (block != expected) {
+            Cancel();
+            return PROTOCOL_ERROR;
+        }
+
+        uint32_t count = length;
+        if (_size > 0 && count > _size - _received) {
+            // the last block is padded
+            count = _size - _received;
+        }
+        if (count > 0 && !sink(_packet + 2, count)) {
+            Cancel();
+            return WRITE_FAILED;
+        }
+
+        _received += count;
+        expected++;
+        eots = 0;
+        errors = 0;
+        Put(ACK);
+    }
+}
+
+uint32_t YmodemReceiver::Received() const {
+    return _received;
+}
+
+const char* YmodemReceiver::Name() const {
+    return _name;
+}
+
+uint32_t YmodemReceiver::Size() const {
+    return _size;
+}
+
+uint32_t YmodemReceiver::Duration() const {
+    return _duration;
+}
+
+int YmodemReceiver::ReadPacket() {
+    uint8_t c;
+    uint32_t length;
+
+    if (!Read(&c, 1, PacketTimeout)) {
+        return PACKET_TIMEOUT;
+    }
+
+    switch (c) {
+        case SOH:
+            length = 128;
+            break;
+        case STX:
+            length = 1024;
+            break;
+        case EOT:
+            return PACKET_EOT;
+        case CAN:
+            // two in a row, a single one is noise
+            if (Read(&c, 1, PacketTimeout) && c == CAN) {
+                return PACKET_CANCEL;
+            }
+            return PACKET_CORRUPT;
+        default:
+            return PACKET_CORRUPT;
+    }
+
+    if (!Read(_packet, 2 + length + 2, PacketTimeout)) {
+        return PACKET_CORRUPT;
+    }
+
+    // XMODEM CRC is CRC-16/CCITT with an initial value of 0
+    uint16_t crc = (_packet[2 + length] << 8) | _packet[2 + length + 1];
+    if (_packet[0] != (uint8_t) ~_packet[1] || crc16(_packet + 2, length, 0) != crc) {
+        return PACKET_CORRUPT;
+    }
+
+    return length;
+}
+
+bool YmodemReceiver::Read(uint8_t* data, uint32_t length, uint32_t timeout) {
+    // straight from the console ring into place
+    while (length > 0) {
+        uint32_t count = _rx.Read(data, length, timeout);
+        if (count == 0) {
+            return false;
+        }
+        data += count;
+        length -= count;
+    }
+
+    return true;
+}
+
+bool YmodemReceiver::ParseHeader() {
+    const char* data = (const char*) _packet + 2;
+
+    if (data[0] == 0) {
+        return false;
+    }
+
+    // "name\0size [mtime mode ...]"
+    size_t i = 0;
+    while (data[i] != 0 && i < sizeof(_name) - 1) {
+        _name[i] = data[i];
+        i++;
+    }
+    _name[i] = 0;
+
+    const char* size = data + strnlen(data, 128 - 1) + 1;
+    while (*size >= '0' && *size <= '9') {
+        _size = _size * 10 + (*size - '0');
+        size++;
+    }
+
+    return true;
+}
+
+void YmodemReceiver::Purge() {
+    // wait for the line to go quiet before asking for the block again
+    while (_rx.Read(_packet, sizeof(_packet), 100) > 0) {
+    }
+}
+
+void YmodemReceiver::Put(uint8_t c) {
+    _tx.write(&c, 1);
+}
+
+void YmodemReceiver::Cancel() {
+    static const uint8_t cancel[] = { CAN, CAN, CAN, CAN, CAN };
+    _tx.write(cancel, sizeof(cancel));
+}
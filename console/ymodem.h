@@ -0,0 +1,122 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_YMODEM__
+#define __MTS_YMODEM__
+
+#include "mbed.h"
+#include "console_rx.h"
+#include "console_tx.h"
+
+/**
+ * YMODEM receiver over the console, accepts 128 byte and 1K blocks with
+ * CRC16. Block data is handed to a sink as it arrives, trimmed to the size
+ * in the header block, so a file never has to fit in RAM. One file is
+ * taken per transfer, the sender is cancelled if it offers more.
+ *
+ * Nothing else may write to the console during a transfer, the rx command
+ * only runs it in boot command mode.
+ */
+class YmodemReceiver {
+
+    public:
+
+        enum Result {
+            DONE,
+            NO_FILE,            // sender ended the batch without a file
+            CANCELLED,          // by the sender
+            TIMEOUT,
+            WRITE_FAILED,       // the sink returned false
+            PROTOCOL_ERROR
+        };
+
+        YmodemReceiver(ConsoleRx& rx, ConsoleTx& tx);
+
+        /**
+         * Receive one file, sink gets its data in order
+         */
+        Result Receive(Callback<bool(const uint8_t*, uint32_t)> sink);
+
+        /**
+         * Bytes passed to the sink by the last transfer
+         */
+        uint32_t Received() const;
+
+        /**
+         * File name and size sent by the host, size 0 if it sent none
+         */
+        const char* Name() const;
+        uint32_t Size() const;
+
+        /**
+         * ms from the header block to the end of the last transfer
+         */
+        uint32_t Duration() const;
+
+    private:
+
+        static const uint8_t SOH = 0x01;
+        static const uint8_t STX = 0x02;
+        static const uint8_t EOT = 0x04;
+        static const uint8_t ACK = 0x06;
+        static const uint8_t NAK = 0x15;
+        static const uint8_t CAN = 0x18;
+        static const uint8_t CRC = 'C';
+
+        static const uint32_t PacketTimeout = 1000;     // ms
+        static const uint32_t StartAttempts = 60;       // 'C' sent once per timeout
+        static const uint8_t MaxErrors = 10;
+
+        // ReadPacket results besides a block length
+        enum {
+            PACKET_TIMEOUT = -1,
+            PACKET_CORRUPT = -2,
+            PACKET_EOT = -3,
+            PACKET_CANCEL = -4
+        };
+
+        int ReadPacket();
+        bool Read(uint8_t* data, uint32_t length, uint32_t timeout);
+        bool ParseHeader();
+        void Purge();
+        void Put(uint8_t c);
+        void Cancel();
+
+        ConsoleRx& _rx;
+        ConsoleTx& _tx;
+
+        // block number, its complement, up to 1K of data and the CRC
+        uint8_t _packet[2 + 1024 + 2];
+        char _name[32];
+        uint32_t _size;
+        uint32_t _received;
+        uint64_t _started;
+        uint32_t _duration;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "deferred_trace.h"
+
+#if !MBED_CONF_APP_TRACE_DEFERRED
+// only text mode links the format strings into the image
+#define TRACE_FORMAT(id, format) format,
+const char* const trace_format_strings[] = {
+#include "trace_formats.h"
+};
+#undef TRACE_FORMAT
+#endif
+
+DeferredTrace::DeferredTrace()
+:   _enqueue(0),
+    _dequeue(0),
+    _dropped(0),
+    _console(NULL)
+{
+    for (uint32_t i = 0; i < Slots; i++) {
+        _slots[i].Sequence = i;
+    }
+}
+
+void DeferredTrace::Start(ConsoleTx& console) {
+    _console = &console;
+}
+
+void DeferredTrace::Record(uint16_t id, uint8_t count, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+    uint32_t position = _enqueue;
+    trace_slot* slot;
+
+    // bounded multi producer queue: a slot whose sequence equals the
+    // enqueue position is free, claim it by advancing the position
+    while (true) {
+        slot = &_slots[position & (Slots - 1)];
+        int32_t diff = (int32_t) (slot->Sequence - position);
+
+        if (diff == 0) {
+            if (core_util_atomic_cas_u32(&_enqueue, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            core_util_atomic_incr_u32(&_dropped, 1);
+            return;
+        } else {
+            position = _enqueue;
+        }
+    }
+
+    slot->Id = id;
+    slot->Count = count;
+    slot->Timestamp = us_ticker_read();
+    slot->Args[0] = a0;
+    slot->Args[1] = a1;
+    slot->Args[2] = a2;
+    slot->Args[3] = a3;
+
+    // publish, the consumer only reads the slot once it sees the sequence
+    __DMB();
+    slot->Sequence = position + 1;
+
+    if (position == _dequeue && _ready) {
+        _ready();
+    }
+}
+
+void DeferredTrace::Attach(Callback<void()> ready) {
+    _ready = ready;
+}
+
+static uint8_t put_word(uint8_t* p, uint32_t value) {
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+    return p[0] ^ p[1] ^ p[2] ^ p[3];
+}
+
+uint32_t DeferredTrace::Flush() {
+    uint8_t frame[8 + 4 * TRACE_MAX_ARGS + 1];
+    uint32_t sent = 0;
+
+    if (_console == NULL) {
+        return 0;
+    }
+
+    while (true) {
+        trace_slot* slot = &_slots[_dequeue & (Slots - 1)];
+
+        if (slot->Sequence != _dequeue + 1) {
+            break;
+        }
+
+        __DMB();
+        uint8_t count = slot->Count > TRACE_MAX_ARGS ? TRACE_MAX_ARGS : slot->Count;
+        uint8_t check;
+
+        frame[0] = TRACE_RECORD_MARKER;
+        frame[1] = slot->Id;
+        frame[2] = slot->Id >> 8;
+        frame[3] = count;
+        check = frame[1] ^ frame[2] ^ frame[3];
+        check ^= put_word(&frame[4], slot->Timestamp);
+        for (uint8_t i = 0; i < count; i++) {
+            check ^= put_word(&frame[8 + 4 * i], slot->Args[i]);
+        }
+        frame[8 + 4 * count] = check;
+
+        if (!_console->TryWrite(frame, 9 + 4 * count)) {
+            // console busy, the record stays queued for the next round
+            break;
+        }
+
+        // hand the slot back to the producers one lap ahead
+        __DMB();
+        slot->Sequence = _dequeue + Slots;
+        _dequeue++;
+        sent++;
+    }
+
+    return sent;
+}
+
+uint32_t DeferredTrace::Pending() const {
+    return _enqueue - _dequeue;
+}
+
+uint32_t DeferredTrace::Dropped() const {
+    return _dropped;
+}
@@ -0,0 +1,146 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_DEFERRED_TRACE__
+#define __MTS_DEFERRED_TRACE__
+
+#include "mbed.h"
+#include "console_tx.h"
+
+#define TRACE_FORMAT(id, format) id,
+enum trace_format_id {
+#include "trace_formats.h"
+        TRACE_FORMAT_COUNT
+};
+#undef TRACE_FORMAT
+
+#define TRACE_MAX_ARGS      4
+
+// first byte of a binary record on the console, never part of text output
+#define TRACE_RECORD_MARKER 0xA5
+
+/**
+ * Deferred binary tracing. A trace point stores its format id, a
+ * microsecond timestamp and up to four raw arguments in a fixed size slot
+ * of a lock free ring, which takes a few dozen cycles and no formatting.
+ * The trace thread of trace_helper is woken when a record arrives and
+ * streams it to the console, retrying every trace-flush-interval ms only
+ * while the console is too full to take it, as
+ *
+ *    0     TRACE_RECORD_MARKER
+ *    1-2   format id, little endian
+ *    3     argument count
+ *    4-7   timestamp in us, little endian
+ *    then  4 bytes per argument, little endian
+ *    last  xor of the bytes after the marker
+ *
+ * interleaved with the regular text output. tools/trace_decoder.py turns
+ * them back into text using trace_formats.h.
+ *
+ * Any number of threads and interrupts can record, a full ring drops the
+ * new record and counts it.
+ */
+class DeferredTrace {
+
+    public:
+
+        DeferredTrace();
+
+        /**
+         * Records are sent to console from now on
+         */
+        void Start(ConsoleTx& console);
+
+        void Record(uint16_t id, uint8_t count, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+        /**
+         * Called from the recorder's context once a record was published
+         * to a queue the consumer had emptied
+         */
+        void Attach(Callback<void()> ready);
+
+        /**
+         * Send as many pending records as the console can take without
+         * waiting, returns the number sent
+         */
+        uint32_t Flush();
+
+        uint32_t Pending() const;
+
+        /**
+         * Records dropped because the ring was full
+         */
+        uint32_t Dropped() const;
+
+    private:
+
+        typedef struct {
+                volatile uint32_t Sequence;     // ring position the slot is free or full for
+                uint16_t Id;
+                uint8_t Count;
+                uint32_t Timestamp;
+                uint32_t Args[TRACE_MAX_ARGS];
+        } trace_slot;
+
+        static const uint32_t Slots = MBED_CONF_APP_TRACE_BUFFER_RECORDS;
+
+        MBED_STRUCT_STATIC_ASSERT((Slots & (Slots - 1)) == 0, "trace-buffer-records must be a power of two");
+
+        trace_slot _slots[Slots];
+        volatile uint32_t _enqueue;
+        volatile uint32_t _dequeue;
+        volatile uint32_t _dropped;
+        ConsoleTx* _console;
+        Callback<void()> _ready;
+};
+
+extern DeferredTrace deferred_trace;
+
+#if !MBED_CONF_APP_TRACE_DEFERRED
+extern const char* const trace_format_strings[];
+#endif
+
+/**
+ * Trace point, recorded in binary with trace-deferred and printed right
+ * away otherwise
+ */
+inline void app_trace(uint16_t id, uint8_t count, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+#if MBED_CONF_APP_TRACE_DEFERRED
+    deferred_trace.Record(id, count, a0, a1, a2, a3);
+#else
+    printf(trace_format_strings[id], a0, a1, a2, a3);
+#endif
+}
+
+#define APP_TRACE0(id)                  app_trace(id, 0, 0, 0, 0, 0)
+#define APP_TRACE1(id, a)               app_trace(id, 1, (uint32_t) (a), 0, 0, 0)
+#define APP_TRACE2(id, a, b)            app_trace(id, 2, (uint32_t) (a), (uint32_t) (b), 0, 0)
+#define APP_TRACE3(id, a, b, c)         app_trace(id, 3, (uint32_t) (a), (uint32_t) (b), (uint32_t) (c), 0)
+#define APP_TRACE4(id, a, b, c, d)      app_trace(id, 4, (uint32_t) (a), (uint32_t) (b), (uint32_t) (c), (uint32_t) (d))
+
+#endif
@@ -0,0 +1,150 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "memory_monitor.h"
+#include "platform/mbed_stats.h"
+#include "mbed_boot.h"
+#include "deferred_trace.h"
+
+#define MEMORY_PAINT        0xA5
+
+typedef struct {
+        const char* Name;
+        uint32_t Size;
+} memory_buffer;
+
+static memory_buffer buffers[MEMORY_MAX_BUFFERS];
+static uint8_t buffer_count;
+
+static uint8_t* queue_start;
+static uint32_t queue_length;
+
+/**
+ * Bytes from start up to the last one that lost its paint
+ */
+static uint32_t painted_peak(const uint8_t* start, uint32_t length) {
+    while (length > 0 && start[length - 1] == MEMORY_PAINT) {
+        length--;
+    }
+
+    return length;
+}
+
+static void paint_isr_stack() {
+    CriticalSectionLock lock;
+
+    // below what is in use now, with room for an exception frame
+    uint8_t* end = (uint8_t*) (uintptr_t) __get_MSP() - 64;
+    for (uint8_t* p = mbed_stack_isr_start; p < end; p++) {
+        *p = MEMORY_PAINT;
+    }
+}
+
+void memory_init(uint8_t* queue_buffer, uint32_t queue_size) {
+    paint_isr_stack();
+
+    // the queue carves events from the start of its buffer
+    memset(queue_buffer, MEMORY_PAINT, queue_size);
+    queue_start = queue_buffer;
+    queue_length = queue_size;
+    memory_add_buffer("event queue", queue_size);
+}
+
+void memory_add_buffer(const char* name, uint32_t size) {
+    if (buffer_count < MEMORY_MAX_BUFFERS) {
+        buffers[buffer_count].Name = name;
+        buffers[buffer_count].Size = size;
+        buffer_count++;
+    }
+}
+
+uint32_t memory_queue_peak() {
+    return queue_start ? painted_peak(queue_start, queue_length) : 0;
+}
+
+uint32_t memory_isr_stack_peak() {
+    // the stack grows down, the paint is left at the bottom
+    const uint8_t* p = mbed_stack_isr_start;
+    const uint8_t* top = mbed_stack_isr_start + mbed_stack_isr_size;
+
+    while (p < top && *p == MEMORY_PAINT) {
+        p++;
+    }
+
+    return top - p;
+}
+
+void memory_print() {
+    printf("\r\nstack        size   peak   free\r\n");
+#if defined (MBED_THREAD_STATS_ENABLED)
+    mbed_stats_thread_t threads[MEMORY_MAX_THREADS];
+    size_t count = mbed_stats_thread_get_each(threads, MEMORY_MAX_THREADS);
+
+    for (size_t i = 0; i < count; i++) {
+        printf("%-10s %6lu %6lu %6lu\r\n", threads[i].name ? threads[i].name : "?", threads[i].stack_size,
+               threads[i].stack_size - threads[i].stack_space, threads[i].stack_space);
+    }
+#else
+    printf("thread stats disabled\r\n");
+#endif
+    uint32_t isr_peak = memory_isr_stack_peak();
+    printf("%-10s %6lu %6lu %6lu\r\n", "isr", mbed_stack_isr_size, isr_peak, mbed_stack_isr_size - isr_peak);
+
+#if defined (MBED_HEAP_STATS_ENABLED)
+    mbed_stats_heap_t heap;
+    mbed_stats_heap_get(&heap);
+    printf("heap %lu bytes, peak %lu of %lu, %lu failed allocations\r\n", heap.current_size, heap.max_size,
+           heap.reserved_size, heap.alloc_fail_cnt);
+#else
+    printf("heap stats disabled\r\n");
+#endif
+
+    printf("event queue peak %lu of %lu bytes\r\n", memory_queue_peak(), queue_length);
+
+    printf("static buffers\r\n");
+    for (uint8_t i = 0; i < buffer_count; i++) {
+        printf("%-16s %6lu\r\n", buffers[i].Name, buffers[i].Size);
+    }
+}
+
+void memory_trace() {
+    mbed_stats_thread_t threads[MEMORY_MAX_THREADS];
+    size_t count = mbed_stats_thread_get_each(threads, MEMORY_MAX_THREADS);
+    uint32_t least_free = mbed_stack_isr_size - memory_isr_stack_peak();
+
+    for (size_t i = 0; i < count; i++) {
+        if (threads[i].stack_space < least_free) {
+            least_free = threads[i].stack_space;
+        }
+    }
+
+    mbed_stats_heap_t heap;
+    mbed_stats_heap_get(&heap);
+
+    APP_TRACE4(TRACE_MEMORY, heap.max_size, memory_queue_peak(), queue_length, least_free);
+}
@@ -0,0 +1,78 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_MEMORY_MONITOR__
+#define __MTS_MEMORY_MONITOR__
+
+#include "mbed.h"
+
+/**
+ * RAM headroom. Thread stacks are painted by the RTOS (platform
+ * stack-stats-enabled) and the interrupt stack and the event queue buffer
+ * are painted here, the deepest byte that lost its paint is the high water
+ * mark. With the heap statistics and the static buffers registered with
+ * memory_add_buffer it is shown by the mem command and traced every
+ * memory-trace-interval ms.
+ */
+
+#define MEMORY_MAX_BUFFERS      12
+#define MEMORY_MAX_THREADS      8
+
+/**
+ * Paint the interrupt stack and the event queue buffer, call before the
+ * queue has events
+ */
+void memory_init(uint8_t* queue_buffer, uint32_t queue_size);
+
+/**
+ * Report a statically allocated buffer, name must stay valid
+ */
+void memory_add_buffer(const char* name, uint32_t size);
+
+/**
+ * Peak bytes of the event queue buffer taken by events, accurate to the
+ * size of one event
+ */
+uint32_t memory_queue_peak();
+
+/**
+ * Peak bytes used of the interrupt stack
+ */
+uint32_t memory_isr_stack_peak();
+
+/**
+ * Print stacks, heap, event queue and static buffers
+ */
+void memory_print();
+
+/**
+ * Trace heap peak, event queue peak and the least free stack of any thread
+ */
+void memory_trace();
+
+#endif
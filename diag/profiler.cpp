@@ -0,0 +1,106 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "profiler.h"
+
+static const char* const probe_names[PROFILE_PROBE_COUNT] = {
+    "event",
+    "send",
+    "fs read",
+    "fs write",
+    "fs erase",
+    "flash read",
+    "flash write",
+    "flash erase"
+};
+
+static profile_stats stats[PROFILE_PROBE_COUNT];
+
+#if defined (DWT) && defined (CoreDebug_DEMCR_TRCENA_Msk)
+#define HAS_CYCLE_COUNTER
+#endif
+
+void profile_init() {
+#if defined (HAS_CYCLE_COUNTER)
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+#endif
+    profile_reset();
+}
+
+uint32_t profile_cycles() {
+#if defined (HAS_CYCLE_COUNTER)
+    return DWT->CYCCNT;
+#else
+    return osKernelGetSysTimerCount();
+#endif
+}
+
+uint32_t profile_frequency() {
+#if defined (HAS_CYCLE_COUNTER)
+    return SystemCoreClock;
+#else
+    return osKernelGetSysTimerFreq();
+#endif
+}
+
+void profile_record(uint8_t probe, uint32_t cycles) {
+    if (probe >= PROFILE_PROBE_COUNT) {
+        return;
+    }
+
+    // probes run in several threads, the update is a handful of instructions
+    CriticalSectionLock lock;
+    profile_stats& s = stats[probe];
+
+    if (s.Count == 0 || cycles < s.Min) {
+        s.Min = cycles;
+    }
+    if (cycles > s.Max) {
+        s.Max = cycles;
+    }
+    s.Total += cycles;
+    s.Count++;
+}
+
+profile_stats profile_get(uint8_t probe) {
+    CriticalSectionLock lock;
+    return stats[probe < PROFILE_PROBE_COUNT ? probe : 0];
+}
+
+const char* profile_name(uint8_t probe) {
+    return probe < PROFILE_PROBE_COUNT ? probe_names[probe] : "";
+}
+
+void profile_reset() {
+    CriticalSectionLock lock;
+    memset(stats, 0, sizeof(stats));
+}
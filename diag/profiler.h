@@ -0,0 +1,113 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_PROFILER__
+#define __MTS_PROFILER__
+
+#include "mbed.h"
+
+/**
+ * Execution time probes. Cycles come from DWT->CYCCNT where the core has
+ * one (Cortex-M3 and up) and from the RTOS SysTick based timer otherwise
+ * (Cortex-M0+), which is coarser but needs no debug unit. Each probe keeps
+ * count, min, max and total, shown by the prof command.
+ *
+ * Build with profiling set to false to compile the probes out.
+ */
+enum profile_probe {
+        PROFILE_EVENT_HANDLER,
+        PROFILE_SEND_MESSAGE,
+        PROFILE_SPIFFS_READ,
+        PROFILE_SPIFFS_WRITE,
+        PROFILE_SPIFFS_ERASE,
+        PROFILE_FLASH_READ,
+        PROFILE_FLASH_WRITE,
+        PROFILE_FLASH_ERASE,
+        PROFILE_PROBE_COUNT
+};
+
+typedef struct {
+        uint32_t Count;
+        uint32_t Min;           // cycles
+        uint32_t Max;           // cycles
+        uint64_t Total;         // cycles
+} profile_stats;
+
+/**
+ * Start the cycle counter, safe to call more than once
+ */
+void profile_init();
+
+uint32_t profile_cycles();
+
+/**
+ * Cycle counter frequency in Hz
+ */
+uint32_t profile_frequency();
+
+void profile_record(uint8_t probe, uint32_t cycles);
+
+/**
+ * Copy of the statistics of probe, taken atomically
+ */
+profile_stats profile_get(uint8_t probe);
+
+const char* profile_name(uint8_t probe);
+
+void profile_reset();
+
+/**
+ * Times the enclosing scope
+ */
+class ProfileScope {
+
+    public:
+
+        ProfileScope(uint8_t probe)
+        :   _probe(probe),
+            _start(profile_cycles())
+        {
+        }
+
+        ~ProfileScope() {
+            profile_record(_probe, profile_cycles() - _start);
+        }
+
+    private:
+
+        uint8_t _probe;
+        uint32_t _start;
+};
+
+#if MBED_CONF_APP_PROFILING
+#define PROFILE_SCOPE(probe)    ProfileScope profile_scope(probe)
+#else
+#define PROFILE_SCOPE(probe)
+#endif
+
+#endif
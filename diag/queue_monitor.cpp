@@ -0,0 +1,181 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "queue_monitor.h"
+#include "profiler.h"
+
+static const char* const event_names[QUEUE_EVENT_COUNT] = {
+    "shell",
+    "sample",
+    "send",
+    "join",
+    "memory",
+    "flash sleep"
+};
+
+static queue_event_stats stats[QUEUE_EVENT_COUNT];
+
+static uint32_t now_ms() {
+    return (uint32_t) Kernel::get_ms_count();
+}
+
+static void record(uint8_t event, uint32_t latency, uint32_t run_us) {
+    CriticalSectionLock lock;
+    queue_event_stats& s = stats[event];
+
+    if (latency > s.LatencyMax) {
+        s.LatencyMax = latency;
+    }
+    if (run_us > s.RunMax) {
+        s.RunMax = run_us;
+    }
+    s.LatencyTotal += latency;
+    s.Count++;
+}
+
+queue_event_stats queue_event_get(uint8_t event) {
+    CriticalSectionLock lock;
+    return stats[event < QUEUE_EVENT_COUNT ? event : 0];
+}
+
+const char* queue_event_name(uint8_t event) {
+    return event < QUEUE_EVENT_COUNT ? event_names[event] : "";
+}
+
+QueueMonitor::TimedEvent::TimedEvent(QueueMonitor* monitor, void (*handler)(), uint8_t event, int delay, int period)
+:   _monitor(monitor),
+    _handler(handler),
+    _due(now_ms() + delay),
+    _period(period),
+    _event(event)
+{
+}
+
+QueueMonitor::TimedEvent::~TimedEvent() {
+    // the copy the queue holds is destroyed once it ran or was cancelled,
+    // copies made on the way in live outside the buffer
+    _monitor->Removed(this);
+}
+
+void QueueMonitor::TimedEvent::operator()() {
+    uint32_t now = now_ms();
+    // late by up to a tick shows as a huge wrap around otherwise
+    uint32_t latency = (int32_t) (now - _due) > 0 ? now - _due : 0;
+    uint32_t start = profile_cycles();
+
+    _handler();
+
+    uint32_t cycles = profile_cycles() - start;
+    record(_event, latency, (uint64_t) cycles * 1000000 / profile_frequency());
+    _due += _period;
+}
+
+QueueMonitor::QueueMonitor(events::EventQueue& queue, const uint8_t* buffer, uint32_t size, const char* name)
+:   _queue(queue),
+    _buffer(buffer),
+    _size(size),
+    _name(name),
+    _pending(0),
+    _peak(0),
+    _failed(0)
+{
+}
+
+int QueueMonitor::Call(uint8_t event, void (*handler)()) {
+    Posting();
+    return Posted(_queue.call(TimedEvent(this, handler, event, 0, 0)));
+}
+
+int QueueMonitor::CallIn(int ms, uint8_t event, void (*handler)()) {
+    Posting();
+    return Posted(_queue.call_in(ms, TimedEvent(this, handler, event, ms, 0)));
+}
+
+int QueueMonitor::CallEvery(int ms, uint8_t event, void (*handler)()) {
+    Posting();
+    return Posted(_queue.call_every(ms, TimedEvent(this, handler, event, ms, ms)));
+}
+
+void QueueMonitor::Cancel(int id) {
+    // the destructor of a pending event takes it off the count
+    _queue.cancel(id);
+}
+
+/**
+ * Counted before the post, the event may run and be destroyed before the
+ * post returns when a higher priority thread dispatches the queue
+ */
+void QueueMonitor::Posting() {
+    CriticalSectionLock lock;
+    _pending++;
+}
+
+int QueueMonitor::Posted(int id) {
+    CriticalSectionLock lock;
+
+    if (id == 0) {
+        _pending--;
+        _failed++;
+    } else if (_pending > _peak) {
+        _peak = _pending;
+    }
+
+    return id;
+}
+
+void QueueMonitor::Removed(const void* event) {
+    const uint8_t* p = (const uint8_t*) event;
+
+    if (p >= _buffer && p < _buffer + _size) {
+        CriticalSectionLock lock;
+        _pending--;
+    }
+}
+
+const char* QueueMonitor::Name() const {
+    return _name;
+}
+
+uint32_t QueueMonitor::Pending() const {
+    return _pending;
+}
+
+uint32_t QueueMonitor::PeakPending() const {
+    return _peak;
+}
+
+uint32_t QueueMonitor::Failed() const {
+    return _failed;
+}
+
+void QueueMonitor::ResetCounters() {
+    CriticalSectionLock lock;
+    _peak = _pending;
+    _failed = 0;
+    memset(stats, 0, sizeof(stats));
+}
@@ -0,0 +1,133 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_QUEUE_MONITOR__
+#define __MTS_QUEUE_MONITOR__
+
+#include "mbed.h"
+#include "events/EventQueue.h"
+
+/**
+ * Application events posted through a QueueMonitor, each keeps how often it
+ * ran, how late it was dispatched and how long it ran, shown by the events
+ * command.
+ */
+enum queue_event {
+        QUEUE_EVENT_SHELL,
+        QUEUE_EVENT_SAMPLE,
+        QUEUE_EVENT_SEND,
+        QUEUE_EVENT_JOIN,
+        QUEUE_EVENT_MEMORY,
+        QUEUE_EVENT_FLASH_SLEEP,
+        QUEUE_EVENT_COUNT
+};
+
+typedef struct {
+        uint32_t Count;
+        uint32_t LatencyMax;    // ms after the event was due
+        uint32_t LatencyTotal;  // ms
+        uint32_t RunMax;        // us
+} queue_event_stats;
+
+/**
+ * Copy of the statistics of event, taken atomically
+ */
+queue_event_stats queue_event_get(uint8_t event);
+
+const char* queue_event_name(uint8_t event);
+
+/**
+ * Posts application events to a queue with a static buffer and counts the
+ * events pending in it, their peak and the posts that failed for lack of
+ * room. Events of the LoRaWAN stack go to the queue directly and are not
+ * counted, memory_queue_peak covers the whole buffer.
+ *
+ * Posting is safe from any thread, dispatch happens in the queue's thread.
+ */
+class QueueMonitor {
+
+    public:
+
+        QueueMonitor(events::EventQueue& queue, const uint8_t* buffer, uint32_t size, const char* name);
+
+        /**
+         * Same as EventQueue::call, call_in and call_every, return the
+         * event id or 0 if the queue is full
+         */
+        int Call(uint8_t event, void (*handler)());
+        int CallIn(int ms, uint8_t event, void (*handler)());
+        int CallEvery(int ms, uint8_t event, void (*handler)());
+
+        void Cancel(int id);
+
+        const char* Name() const;
+        uint32_t Pending() const;
+        uint32_t PeakPending() const;
+        uint32_t Failed() const;
+
+        /**
+         * Clears the peak and failure counts and the event statistics
+         */
+        void ResetCounters();
+
+    private:
+
+        // what the queue stores per event, a few bytes more than the
+        // Callback a plain call() stores
+        class TimedEvent {
+
+            public:
+
+                TimedEvent(QueueMonitor* monitor, void (*handler)(), uint8_t event, int delay, int period);
+                ~TimedEvent();
+
+                void operator()();
+
+            private:
+
+                QueueMonitor* _monitor;
+                void (*_handler)();
+                uint32_t _due;          // ms, kernel tick count
+                uint32_t _period;       // ms, 0 for a one shot event
+                uint8_t _event;
+        };
+
+        void Posting();
+        int Posted(int id);
+        void Removed(const void* event);
+
+        events::EventQueue& _queue;
+        const uint8_t* _buffer;
+        uint32_t _size;
+        const char* _name;
+        volatile uint32_t _pending;
+        uint32_t _peak;
+        volatile uint32_t _failed;
+};
+
+#endif
@@ -0,0 +1,45 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+// Application trace formats, expanded with a TRACE_FORMAT(id, format)
+// macro. A format's position in this table is the id deferred tracing
+// sends instead of the text, tools/trace_decoder.py reads this file to
+// turn the ids back into text. Only append, never reorder or remove.
+//
+// Arguments are recorded as 32 bit words, at most four per format, use
+// %d, %u, %x or %c (length modifiers are ignored) and no %s or floats.
+
+TRACE_FORMAT(TRACE_MESSAGE_SENT, "\r\n Message Sent to Network Server \r\n")
+TRACE_FORMAT(TRACE_MESSAGE_RECEIVED, "\r\n Received message from Network Server \r\n")
+TRACE_FORMAT(TRACE_TX_SCHEDULED, "\r\n %d bytes scheduled for transmission, %lu of %lu readings, %lu ms on air \r\n")
+TRACE_FORMAT(TRACE_NEXT_UPLINK, "\r\n Next uplink in %lu ms \r\n")
+TRACE_FORMAT(TRACE_TX_ERROR, "\r\n Transmission Error - EventCode = %d - retry %lu in %lu ms \r\n")
+TRACE_FORMAT(TRACE_RX_ERROR, "\r\n Error in reception - Code = %d \r\n")
+TRACE_FORMAT(TRACE_JOIN_FAILED, "\r\n OTAA Failed - Check Keys - retry %lu in %lu ms \r\n")
+TRACE_FORMAT(TRACE_UPLINK_REQUIRED, "\r\n Uplink required by NS \r\n")
+TRACE_FORMAT(TRACE_MEMORY, "\r\n Memory: heap peak %lu, event queue peak %lu of %lu, least free stack %lu \r\n")
@@ -0,0 +1,151 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "trace_ring.h"
+
+TraceRing::TraceRing()
+:   _head(0),
+    _tail(0),
+    _dropped(0)
+{
+    memset(_buffer, 0, sizeof(_buffer));
+}
+
+bool TraceRing::Reserve(uint32_t size, uint32_t& position) {
+#if defined (__CORTEX_M) && (__CORTEX_M >= 3)
+    uint32_t head;
+
+    // an interrupt between LDREX and STREX clears the monitor and the
+    // store fails, so the loop always ends with a consistent reservation
+    do {
+        head = __LDREXW(&_head);
+        if (head + size - _tail > MBED_CONF_APP_TRACE_RING_SIZE) {
+            __CLREX();
+            return false;
+        }
+    } while (__STREXW(head + size, &_head));
+
+    position = head;
+    return true;
+#else
+    // Cortex-M0 has no exclusive access, the reservation is a few
+    // instructions under a critical section
+    CriticalSectionLock lock;
+
+    if (_head + size - _tail > MBED_CONF_APP_TRACE_RING_SIZE) {
+        return false;
+    }
+
+    position = _head;
+    _head = position + size;
+    return true;
+#endif
+}
+
+bool TraceRing::Write(const char* text, uint32_t length) {
+    uint8_t* bytes = (uint8_t*) _buffer;
+    uint32_t position;
+
+    if (length > MaxLine) {
+        length = MaxLine;
+    }
+
+    if (!Reserve(4 + ((length + 3) & ~3UL), position)) {
+        core_util_atomic_incr_u32(&_dropped, 1);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < length; i++) {
+        bytes[(position + 4 + i) & Mask] = text[i];
+    }
+
+    // the text must be visible before the header marks it committed
+    __DMB();
+    _buffer[(position & Mask) / 4] = Committed | length;
+
+    // the consumer can't pass an uncommitted line, if the tail is still
+    // here every earlier line was flushed and it may be waiting
+    if (position == _tail && _ready) {
+        _ready();
+    }
+    return true;
+}
+
+uint32_t TraceRing::Flush(ConsoleTx& console) {
+    uint8_t* bytes = (uint8_t*) _buffer;
+    uint8_t line[MaxLine];
+    uint32_t sent = 0;
+
+    while (_tail != _head) {
+        uint32_t header = ((volatile uint32_t*) _buffer)[(_tail & Mask) / 4];
+
+        if (!(header & Committed)) {
+            // the oldest line is still being written
+            break;
+        }
+
+        __DMB();
+        uint32_t length = header & ~Committed;
+        uint32_t size = 4 + ((length + 3) & ~3UL);
+
+        for (uint32_t i = 0; i < length; i++) {
+            line[i] = bytes[(_tail + 4 + i) & Mask];
+        }
+
+        if (!console.TryWrite(line, length)) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < size; i += 4) {
+            _buffer[((_tail + i) & Mask) / 4] = 0;
+        }
+
+        // release the space only after it was cleared
+        __DMB();
+        _tail = _tail + size;
+        sent++;
+    }
+
+    return sent;
+}
+
+void TraceRing::Attach(Callback<void()> ready) {
+    _ready = ready;
+}
+
+bool TraceRing::Pending() const {
+    return _head != _tail;
+}
+
+uint32_t TraceRing::Size() const {
+    return MBED_CONF_APP_TRACE_RING_SIZE;
+}
+
+uint32_t TraceRing::Dropped() const {
+    return _dropped;
+}
@@ -0,0 +1,103 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_TRACE_RING__
+#define __MTS_TRACE_RING__
+
+#include "mbed.h"
+#include "console_tx.h"
+
+/**
+ * Lock free multi producer ring of text trace lines.
+ *
+ * A producer reserves space for its line by advancing the head atomically,
+ * with LDREX/STREX on cores that have them and a critical section on
+ * Cortex-M0, then copies the line and commits it by setting the committed
+ * bit in the record header. No producer ever waits for another or for the
+ * UART, a line that does not fit is dropped and counted.
+ *
+ * Records are a 32 bit header (length | committed) followed by the text,
+ * padded to a multiple of four so headers are always aligned single word
+ * stores. The consumer zeroes what it consumed, so a header that has been
+ * reserved but not yet written reads as uncommitted.
+ */
+class TraceRing {
+
+    public:
+
+        static const uint32_t MaxLine = 160;
+
+        TraceRing();
+
+        /**
+         * Producer side, any thread or interrupt
+         */
+        bool Write(const char* text, uint32_t length);
+
+        /**
+         * Consumer side, move committed lines to console without waiting.
+         * Returns the number of lines sent.
+         */
+        uint32_t Flush(ConsoleTx& console);
+
+        /**
+         * Called from the writer's context once a line was committed to a
+         * ring the consumer had emptied, so it can sleep until then
+         */
+        void Attach(Callback<void()> ready);
+
+        /**
+         * Lines reserved but not flushed yet
+         */
+        bool Pending() const;
+
+        uint32_t Size() const;
+
+        /**
+         * Lines dropped because the ring was full
+         */
+        uint32_t Dropped() const;
+
+    private:
+
+        static const uint32_t Committed = 0x80000000;
+        static const uint32_t Mask = MBED_CONF_APP_TRACE_RING_SIZE - 1;
+
+        MBED_STRUCT_STATIC_ASSERT((MBED_CONF_APP_TRACE_RING_SIZE & Mask) == 0 && MBED_CONF_APP_TRACE_RING_SIZE >= 256,
+                                  "trace-ring-size must be a power of two of at least 256");
+
+        bool Reserve(uint32_t size, uint32_t& position);
+
+        Callback<void()> _ready;
+        uint32_t _buffer[MBED_CONF_APP_TRACE_RING_SIZE / 4];
+        volatile uint32_t _head;
+        volatile uint32_t _tail;
+        volatile uint32_t _dropped;
+};
+
+#endif
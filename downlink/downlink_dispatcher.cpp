@@ -0,0 +1,143 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+#include "downlink_dispatcher.h"
+#include "trace_helper.h"
+
+// bytes per trace line, "xx " each must fit in TraceRing::MaxLine
+#define DUMP_BYTES_PER_LINE     32
+
+DownlinkDispatcher::DownlinkDispatcher()
+    : _received(0),
+      _unhandled(0)
+{
+    for (uint8_t i = 0; i < MBED_CONF_APP_DOWNLINK_HANDLERS; i++) {
+        _handlers[i].Port = 0;
+        _handlers[i].Used = false;
+    }
+}
+
+bool DownlinkDispatcher::Register(uint8_t port, downlink_handler handler)
+{
+    port_handler* free_entry = NULL;
+
+    for (uint8_t i = 0; i < MBED_CONF_APP_DOWNLINK_HANDLERS; i++) {
+        if (_handlers[i].Used && _handlers[i].Port == port) {
+            _handlers[i].Handler = handler;
+            return true;
+        }
+        if (!_handlers[i].Used && free_entry == NULL) {
+            free_entry = &_handlers[i];
+        }
+    }
+
+    if (free_entry == NULL) {
+        return false;
+    }
+
+    free_entry->Handler = handler;
+    free_entry->Port = port;
+    free_entry->Used = true;
+    return true;
+}
+
+void DownlinkDispatcher::Unregister(uint8_t port)
+{
+    for (uint8_t i = 0; i < MBED_CONF_APP_DOWNLINK_HANDLERS; i++) {
+        if (_handlers[i].Used && _handlers[i].Port == port) {
+            _handlers[i].Handler = downlink_handler();
+            _handlers[i].Used = false;
+        }
+    }
+}
+
+void DownlinkDispatcher::SetDefault(downlink_handler handler)
+{
+    _default = handler;
+}
+
+uint8_t* DownlinkDispatcher::Buffer()
+{
+    return _buffer;
+}
+
+void DownlinkDispatcher::Dispatch(uint8_t port, uint16_t length, int flags)
+{
+    downlink_payload payload;
+    payload.Data = _buffer;
+    payload.Length = length > BufferSize ? BufferSize : length;
+    payload.Port = port;
+    payload.Flags = flags;
+
+    _received++;
+
+    if (trace_level & TRACE_LEVEL_DEBUG) {
+        Dump(payload);
+    }
+
+    for (uint8_t i = 0; i < MBED_CONF_APP_DOWNLINK_HANDLERS; i++) {
+        if (_handlers[i].Used && _handlers[i].Port == port) {
+            _handlers[i].Handler(payload);
+            return;
+        }
+    }
+
+    _unhandled++;
+    if (_default) {
+        _default(payload);
+    }
+}
+
+uint32_t DownlinkDispatcher::Received() const
+{
+    return _received;
+}
+
+uint32_t DownlinkDispatcher::Unhandled() const
+{
+    return _unhandled;
+}
+
+void DownlinkDispatcher::Dump(const downlink_payload& payload)
+{
+    char line[DUMP_BYTES_PER_LINE * 3 + 1];
+
+    APP_DEBUG("RX port %u, %u bytes", payload.Port, payload.Length);
+
+    for (uint16_t offset = 0; offset < payload.Length; offset += DUMP_BYTES_PER_LINE) {
+        uint16_t count = payload.Length - offset;
+        if (count > DUMP_BYTES_PER_LINE) {
+            count = DUMP_BYTES_PER_LINE;
+        }
+
+        for (uint16_t i = 0; i < count; i++) {
+            snprintf(&line[i * 3], 4, "%02x ", payload.Data[offset + i]);
+        }
+
+        APP_DEBUG("  %03u: %s", offset, line);
+    }
+}
@@ -0,0 +1,107 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+#ifndef __MTS_DOWNLINK_DISPATCHER__
+#define __MTS_DOWNLINK_DISPATCHER__
+
+#include "mbed.h"
+#include "lorawan/system/lorawan_data_structures.h"
+
+/**
+ * View of a received downlink, points into the dispatcher's buffer.
+ * Only valid for the duration of the handler call, copy anything that
+ * must be kept.
+ */
+struct downlink_payload {
+        const uint8_t* Data;
+        uint16_t Length;
+        uint8_t Port;
+        int Flags;
+};
+
+typedef Callback<void(const downlink_payload&)> downlink_handler;
+
+/**
+ * Routes downlinks to handlers registered per FPort.
+ *
+ * The stack copies the payload once into a buffer sized for the largest
+ * frame the PHY allows, handlers then get a downlink_payload pointing into
+ * it so nothing is copied again. The hex dump of every frame is only
+ * formatted when debug tracing is enabled.
+ */
+class DownlinkDispatcher {
+
+    public:
+
+        static const uint16_t BufferSize = LORAMAC_PHY_MAXPAYLOAD;
+
+        DownlinkDispatcher();
+
+        /**
+         * Route downlinks on port to handler, replaces an existing entry
+         * @return false if the handler table is full
+         */
+        bool Register(uint8_t port, downlink_handler handler);
+
+        void Unregister(uint8_t port);
+
+        /**
+         * Called for ports without a registered handler
+         */
+        void SetDefault(downlink_handler handler);
+
+        /**
+         * Buffer to pass to LoRaWANInterface::receive
+         */
+        uint8_t* Buffer();
+
+        /**
+         * Dispatch length bytes just received into Buffer
+         */
+        void Dispatch(uint8_t port, uint16_t length, int flags);
+
+        uint32_t Received() const;
+        uint32_t Unhandled() const;
+
+    private:
+
+        struct port_handler {
+                downlink_handler Handler;
+                uint8_t Port;
+                bool Used;
+        };
+
+        static void Dump(const downlink_payload& payload);
+
+        port_handler _handlers[MBED_CONF_APP_DOWNLINK_HANDLERS];
+        downlink_handler _default;
+        uint32_t _received;
+        uint32_t _unhandled;
+        uint8_t _buffer[BufferSize];
+};
+
+#endif
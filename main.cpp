@@ -28,18 +28,80 @@
 #include "lora_radio_helper.h"
 
 #include "commands.h"
+#include "config_fields.h"
+#include "uplink_queue.h"
+#include "uplink_batch.h"
+#include "lora_region.h"
+#include "tx_scheduler.h"
+#include "retry_policy.h"
+#include "shell_mailbox.h"
+#include "console_rx.h"
+#include "console_tx.h"
+#include "deferred_trace.h"
+#include "profiler.h"
+#include "memory_monitor.h"
+#include "queue_monitor.h"
+#include "downlink_dispatcher.h"
+
+// The console is defined first, objects constructed later in this file
+// (ConfigManager mounting the file system) already print through it.
+RawSerial pc(USBTX, USBRX);
+
+/**
+ * Interrupt driven console input, read by the boot prompt and the shell
+ */
+ConsoleRx console_rx(pc, MBED_CONF_APP_CONSOLE_WAKE_PIN);
+
+/**
+ * Interrupt driven console output, printf goes through it
+ */
+ConsoleTx console_tx(pc, MBED_CONF_APP_CONSOLE_TX_DROP_OLDEST ? ConsoleTx::DROP_OLDEST : ConsoleTx::DROP_NEWEST);
+
+/**
+ * Binary trace records, streamed to console_tx with trace-deferred
+ */
+DeferredTrace deferred_trace;
+
+FileHandle* mbed::mbed_override_console(int fd) {
+    return &console_tx;
+}
 
 ConfigManager config_mng;
 DeviceConfig_t device_config;
 
+/**
+ * Readings waiting to be sent. Persistent on targets with a file system.
+ */
+UplinkQueue uplink_queue(config_mng, MBED_CONF_APP_UPLINK_QUEUE_SIZE,
+                         MBED_CONF_APP_UPLINK_QUEUE_DROP_OLDEST ? UplinkQueue::DROP_OLDEST : UplinkQueue::DROP_NEWEST);
+
+/**
+ * Packs queued readings into uplink frames
+ */
+static UplinkBatch uplink_batch(uplink_queue);
+
+/**
+ * Duty cycle budget and stack backoff, decides when the next uplink may go
+ */
+static TxScheduler tx_scheduler;
+
+/**
+ * Backoff between join attempts and after failed uplinks
+ */
+static RetryPolicy join_retry;
+static RetryPolicy tx_retry;
+
 
 using namespace events;
 
-// Max payload size can be LORAMAC_PHY_MAXPAYLOAD.
-// This example only communicates with much shorter messages (<30 bytes).
-// If longer messages are used, these buffers must be changed accordingly.
-uint8_t tx_buffer[30];
-uint8_t rx_buffer[30];
+// The stack never accepts more than lora.tx-max-size bytes per uplink.
+// Downlinks land in the dispatcher's LORAMAC_PHY_MAXPAYLOAD buffer.
+uint8_t tx_buffer[MBED_CONF_LORA_TX_MAX_SIZE];
+
+/**
+ * Routes downlinks to handlers by FPort
+ */
+static DownlinkDispatcher downlinks;
 
 /*
  * Sets up an application dependent transmission timer in ms. Used only when Duty Cycling is off for testing
@@ -74,8 +136,30 @@ DS1820  ds1820(PC_9);
 * in the same thread as the application and the application is responsible for
 * providing an event queue to the stack that will be used for ISR deferment as
 * well as application information event queuing.
+*
+* The buffer is static so memory_monitor can track how much of it is used.
 */
-static EventQueue ev_queue(MAX_NUMBER_OF_EVENTS *EVENTS_EVENT_SIZE);
+static uint8_t ev_queue_buffer[MAX_NUMBER_OF_EVENTS * EVENTS_EVENT_SIZE];
+static EventQueue ev_queue(sizeof(ev_queue_buffer), ev_queue_buffer);
+
+/**
+ * Application events are posted through it to count and time them
+ */
+QueueMonitor ev_monitor(ev_queue, ev_queue_buffer, sizeof(ev_queue_buffer), "events");
+
+#if MBED_CONF_APP_MAINTENANCE_QUEUE
+/**
+ * Housekeeping such as the memory trace. Chained into ev_queue, so it runs
+ * in the application thread, one dispatch after the events already pending
+ * there, and it has its own buffer so it never takes the room of the stack
+ * events.
+ */
+static uint8_t maintenance_buffer[MBED_CONF_APP_MAINTENANCE_QUEUE_EVENTS * EVENTS_EVENT_SIZE];
+static EventQueue maintenance_queue(sizeof(maintenance_buffer), maintenance_buffer);
+QueueMonitor maintenance_monitor(maintenance_queue, maintenance_buffer, sizeof(maintenance_buffer), "maintenance");
+#else
+QueueMonitor& maintenance_monitor = ev_monitor;
+#endif
 
 /**
  * Event handler.
@@ -85,6 +169,59 @@ static EventQueue ev_queue(MAX_NUMBER_OF_EVENTS *EVENTS_EVENT_SIZE);
  */
 static void lora_event_handler(lorawan_event_t event);
 static uint8_t lora_battery_handler(void);
+static void next_epoch();
+static void sample_sensor();
+static void send_message();
+static void schedule_send();
+static void join();
+static void serve_shell();
+static lorawan_status_t start_join();
+static void unhandled_downlink(const downlink_payload& payload);
+
+/**
+ * Set while the stack has an active session
+ */
+static bool connected = false;
+
+/**
+ * Set while an uplink is scheduled or being sent
+ */
+static bool tx_pending = false;
+
+/**
+ * Queue sequence of the first reading carried by the uplink in flight and
+ * the number of readings it carries. A reading overwritten while the uplink
+ * is in flight is not popped a second time on TX_DONE.
+ */
+static uint32_t tx_first = 0;
+static uint32_t tx_readings = 0;
+
+/**
+ * Datarate used to size the next batch. Starts at the configured datarate
+ * and follows the datarate of the last uplink when ADR is enabled.
+ */
+static uint8_t tx_datarate = 0;
+
+/**
+ * Estimated time on air of the uplink in flight, used when the stack does
+ * not report one
+ */
+static uint32_t tx_toa = 0;
+
+/**
+ * Id of the pending delayed send_message event, 0 if none
+ */
+static int send_event = 0;
+
+/**
+ * The RTC is never set, time() counts from an arbitrary start. Readings are
+ * stamped with the low 8 bits of a persisted epoch counter, bumped at every
+ * boot and after every 2^24 s (194 days) of uptime, and the seconds since
+ * the epoch began, so the host can tell boots apart and order readings
+ * within one.
+ */
+static const uint32_t EpochSeconds = 1UL << 24;
+static time_t epoch_start = 0;
 
 /**
  * Constructing Mbed LoRaWANInterface and passing it the radio object from lora_radio_helper.
@@ -97,7 +234,21 @@ static LoRaWANInterface lorawan(radio);
 static lorawan_app_callbacks_t callbacks;
 
 
-Serial pc(USBTX, USBRX);
+/**
+ * Commands from the shell thread, served on ev_queue
+ */
+ShellMailbox shell_mailbox;
+
+/**
+ * The shell runs below the application so it never delays the stack
+ */
+static Thread shell_thread(osPriorityLow, MBED_CONF_APP_SHELL_STACK_SIZE, NULL, "shell");
+
+/**
+ * Set while main() holds the stack back in boot command mode, commands that
+ * lock the file system for long only run then
+ */
+volatile bool command_mode = false;
 
 
 void default_configuration() {
@@ -111,27 +262,55 @@ void default_configuration() {
     memcpy(device_config.settings.AppKey, appkey, 16);
 }
 
-void wait_for_command() {
-    bool cmd_mode = false;
+#if defined (TARGET_MTS_MDOT_F411RE)
+/**
+ * Powers the SPI flash down once it was unused for flash-idle-timeout ms
+ */
+static void flash_sleep() {
+    uint32_t remaining;
 
-    Timer tm;
-    tm.start();
+    if (!config_mng.SleepIfIdle(MBED_CONF_APP_FLASH_IDLE_TIMEOUT, remaining)) {
+        maintenance_monitor.CallIn(remaining, QUEUE_EVENT_FLASH_SLEEP, flash_sleep);
+    }
+}
 
-    printf("Press a key to enter command mode\r\n");
+/**
+ * Called whenever an access wakes the flash
+ */
+static void schedule_flash_sleep() {
+    maintenance_monitor.CallIn(MBED_CONF_APP_FLASH_IDLE_TIMEOUT, QUEUE_EVENT_FLASH_SLEEP, flash_sleep);
+}
+#endif /* TARGET_MTS_MDOT_F411RE */
 
-    while (tm.read_ms() < 1000) {
-        if (pc.readable()) {
-            while (pc.readable()) {
-                pc.getc();
-            }
-            cmd_mode = true;
-            break;
-        }
+/**
+ * Called from the shell thread when it posted a request
+ */
+static void notify_shell() {
+    ev_monitor.Call(QUEUE_EVENT_SHELL, serve_shell);
+}
+
+/**
+ * Returns true if the command mode pin is held low, or if a key is pressed
+ * within command-mode-wait ms. The CPU sleeps while waiting and the RX
+ * interrupt wakes it, a wait of 0 boots straight into the application.
+ */
+bool wait_for_command() {
+    bool cmd_mode = false;
+
+    if (MBED_CONF_APP_COMMAND_MODE_PIN != NC) {
+        DigitalIn strap(MBED_CONF_APP_COMMAND_MODE_PIN, PullUp);
+        cmd_mode = (strap.read() == 0);
     }
 
-    if (cmd_mode) {
-        tinyshell_thread();
+    if (!cmd_mode && MBED_CONF_APP_COMMAND_MODE_WAIT > 0) {
+        printf("Press a key to enter command mode\r\n");
+
+        uint8_t key;
+        cmd_mode = (console_rx.Read(&key, 1, MBED_CONF_APP_COMMAND_MODE_WAIT) > 0);
+        console_rx.Flush();
     }
+
+    return cmd_mode;
 }
 
 /**
@@ -139,8 +318,33 @@ void wait_for_command() {
  */
 int main(void)
 {
+    // before anything is queued
+    memory_init(ev_queue_buffer, sizeof(ev_queue_buffer));
+
     // setup tracing
     setup_trace();
+    profile_init();
+
+    memory_add_buffer("device config", sizeof(device_config));
+    memory_add_buffer("uplink queue", sizeof(uplink_queue));
+    memory_add_buffer("console rx", sizeof(console_rx));
+    memory_add_buffer("console tx", sizeof(console_tx));
+    memory_add_buffer("deferred trace", sizeof(deferred_trace));
+    memory_add_buffer("tx buffer", sizeof(tx_buffer));
+    memory_add_buffer("downlinks", sizeof(downlinks));
+#if MBED_CONF_APP_MAINTENANCE_QUEUE
+    memory_add_buffer("maintenance queue", sizeof(maintenance_buffer));
+    maintenance_queue.chain(&ev_queue);
+#endif
+
+    downlinks.SetDefault(unhandled_downlink);
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+    if (MBED_CONF_APP_FLASH_IDLE_TIMEOUT > 0) {
+        config_mng.OnFlashWakeup(schedule_flash_sleep);
+        schedule_flash_sleep();
+    }
+#endif /* TARGET_MTS_MDOT_F411RE */
 
     // stores the status of a call to LoRaWAN protocol
     lorawan_status_t retcode;
@@ -151,7 +355,27 @@ int main(void)
 
     config_mng.Load(device_config);
 
-    wait_for_command();
+    epoch_start = time(NULL);
+    next_epoch();
+
+    uplink_queue.Open();
+    printf("\r\n Uplink queue: %lu readings pending \r\n", uplink_queue.Count());
+
+    console_rx.Start();
+#if MBED_CONF_APP_TRACE_DEFERRED
+    deferred_trace.Start(console_tx);
+#endif
+    bool cmd_mode = wait_for_command();
+
+    // the boot prompt and the shell must not read the console at the same time
+    shell_mailbox.SetNotify(notify_shell);
+    shell_thread.start(tinyshell_thread);
+
+    if (cmd_mode) {
+        // hold the stack back until run so settings changed in the shell apply
+        command_mode = true;
+        ev_queue.dispatch_forever();
+    }
 
     // Initialize LoRaWAN stack
     if (lorawan.initialize(&ev_queue) != LORAWAN_STATUS_OK) {
@@ -205,15 +429,20 @@ int main(void)
 
     printf("\tDevice Class : %s \r\n", (device_config.settings.Class == CLASS_C ? "C" : "A"));
 
-    lorawan_connect_t lwc;
+    // AS923 has no payload at DR0 and DR1 with dwell time limits, a batch
+    // sized for them would be empty and never sent
+    tx_datarate = device_config.settings.EnableADR ? region_min_datarate() : device_config.settings.TxDataRate;
+    if (region_max_payload(tx_datarate) == 0) {
+        tx_datarate = region_min_datarate();
+    }
 
-    lwc.connect_type = LORAWAN_CONNECTION_OTAA;
-    lwc.connection_u.otaa.dev_eui = device_config.provisioning.DeviceEUI;
-    lwc.connection_u.otaa.app_eui = device_config.settings.AppEUI;
-    lwc.connection_u.otaa.app_key = device_config.settings.AppKey;
-    lwc.connection_u.otaa.nb_trials = 3;
+    RetryPolicy::Seed(device_config.provisioning.DeviceEUI, sizeof(device_config.provisioning.DeviceEUI));
+    join_retry.Configure(device_config.app_settings.JoinBackoffMin, device_config.app_settings.JoinBackoffMax,
+                         device_config.app_settings.BackoffJitter);
+    tx_retry.Configure(device_config.app_settings.TxBackoffMin, device_config.app_settings.TxBackoffMax,
+                       device_config.app_settings.BackoffJitter);
 
-    retcode = lorawan.connect(lwc);
+    retcode = start_join();
 
     if (retcode == LORAWAN_STATUS_OK ||
             retcode == LORAWAN_STATUS_CONNECT_IN_PROGRESS) {
@@ -224,6 +453,14 @@ int main(void)
 
     printf("\r\n Connection - In Progress ...\r\n");
 
+    // readings are queued whether or not the device has joined yet,
+    // uplinks carry everything queued since the last one
+    ev_monitor.CallEvery(device_config.app_settings.SampleInterval, QUEUE_EVENT_SAMPLE, sample_sensor);
+    ev_monitor.CallEvery(device_config.app_settings.TxInterval, QUEUE_EVENT_SEND, send_message);
+    if (MBED_CONF_APP_MEMORY_TRACE_INTERVAL > 0) {
+        maintenance_monitor.CallEvery(MBED_CONF_APP_MEMORY_TRACE_INTERVAL, QUEUE_EVENT_MEMORY, memory_trace);
+    }
+
     // make your event queue dispatching events forever
     ev_queue.dispatch_forever();
 
@@ -231,47 +468,248 @@ int main(void)
 }
 
 /**
- * Sends a message to the Network Server
+ * Starts a single OTAA join attempt. Join retries are paced by join_retry.
+ *
+ * The session is not resumed after a reset: LoRaWANInterface neither hands
+ * out the keys of an OTAA session nor lets the frame counters be seeded, and
+ * reusing keys with counters restarted at 0 would repeat the keystream.
  */
-static void send_message()
+static lorawan_status_t start_join()
 {
-    uint16_t packet_len;
-    int16_t retcode;
-    float sensor_value;
+    lorawan_connect_t lwc;
+
+    lwc.connect_type = LORAWAN_CONNECTION_OTAA;
+    lwc.connection_u.otaa.dev_eui = device_config.provisioning.DeviceEUI;
+    lwc.connection_u.otaa.app_eui = device_config.settings.AppEUI;
+    lwc.connection_u.otaa.app_key = device_config.settings.AppKey;
+    lwc.connection_u.otaa.nb_trials = 1;
+
+    return lorawan.connect(lwc);
+}
+
+/**
+ * Join retry after a failed attempt
+ */
+static void join()
+{
+    lorawan_status_t retcode = start_join();
+
+    if (retcode != LORAWAN_STATUS_OK && retcode != LORAWAN_STATUS_CONNECT_IN_PROGRESS) {
+        uint32_t delay = join_retry.Next();
+        printf("\r\n Connection error, code = %d - retry in %lu ms \r\n", retcode, delay);
+        ev_monitor.CallIn(delay, QUEUE_EVENT_JOIN, join);
+    }
+}
+
+/**
+ * Takes a sensor reading and queues it for transmission
+ */
+static void next_epoch()
+{
+    device_config.app_settings.TimeEpoch++;
+    if (!config_mng.SaveSettings(device_config.app_settings)) {
+        APP_ERROR("Saving the time epoch failed");
+    }
+}
+
+static uint32_t reading_time()
+{
+    uint32_t seconds = time(NULL) - epoch_start;
+
+    if (seconds >= EpochSeconds) {
+        epoch_start += EpochSeconds;
+        seconds -= EpochSeconds;
+        next_epoch();
+    }
+
+    return (device_config.app_settings.TimeEpoch << 24) | seconds;
+}
+
+static void sample_sensor()
+{
+    sensor_reading reading;
 
     if (ds1820.begin()) {
         ds1820.startConversion();
-        sensor_value = ds1820.read();
-        printf("\r\n Dummy Sensor Value = %3.1f \r\n", sensor_value);
+        float sensor_value = ds1820.read();
         ds1820.startConversion();
+
+        reading.Timestamp = reading_time();
+        reading.Value = (int16_t) (sensor_value * 10.0f + (sensor_value < 0 ? -0.5f : 0.5f));
+        reading.Sensor = 0;
+        reading.Flags = 0;
+
+        // fixed point, keeps float printf out of the image
+        printf("\r\n Dummy Sensor Value = %s%d.%d \r\n", reading.Value < 0 ? "-" : "",
+               abs(reading.Value) / 10, abs(reading.Value) % 10);
     } else {
         printf("\r\n No sensor found \r\n");
         return;
     }
 
-    packet_len = sprintf((char *) tx_buffer, "Dummy Sensor Value is %3.1f",
-                         sensor_value);
+    if (!uplink_queue.Push(reading)) {
+        APP_WARN("Uplink queue full - reading dropped");
+    }
+}
+
+/**
+ * Sends as many of the oldest queued readings as fit the current datarate
+ */
+static void send_message()
+{
+    PROFILE_SCOPE(PROFILE_SEND_MESSAGE);
+    uint16_t packet_len;
+    int16_t retcode;
+
+    send_event = 0;
+
+    if (!connected || tx_pending) {
+        return;
+    }
+
+    if (tx_scheduler.Delay() > 0) {
+        schedule_send();
+        return;
+    }
+
+    packet_len = uplink_batch.Build(tx_buffer, region_max_payload(tx_datarate));
+    if (packet_len == 0) {
+        return;
+    }
 
     retcode = lorawan.send(device_config.settings.Port, tx_buffer, packet_len,
                            device_config.settings.ACKAttempts > 0 ?  MSG_CONFIRMED_FLAG : MSG_UNCONFIRMED_FLAG);
 
     if (retcode < 0) {
-        retcode == LORAWAN_STATUS_WOULD_BLOCK ? printf("send - WOULD BLOCK\r\n")
-        : printf("\r\n send() - Error code %d \r\n", retcode);
+        if (retcode == LORAWAN_STATUS_WOULD_BLOCK) {
+            APP_DEBUG("send - WOULD BLOCK");
+        } else {
+            APP_ERROR("send() - Error code %d", retcode);
+        }
 
         if (retcode == LORAWAN_STATUS_WOULD_BLOCK) {
-            //retry in 3 seconds
-            if (device_config.app_settings.DutyCycleEnabled) {
-                ev_queue.call_in(3000, send_message);
+            // retry as soon as the stack backoff expires, without one a
+            // transmission is ongoing and its completion triggers the retry
+            int backoff;
+            if (lorawan.get_backoff_metadata(backoff) == LORAWAN_STATUS_OK && backoff > 0) {
+                tx_scheduler.Backoff(backoff);
+                schedule_send();
             }
         }
         return;
     }
 
-    printf("\r\n %d bytes scheduled for transmission \r\n", retcode);
+    tx_pending = true;
+    tx_first = uplink_queue.Tail();
+    tx_readings = uplink_batch.Readings(retcode);
+    tx_toa = TxScheduler::TimeOnAir(tx_datarate, retcode);
+    APP_TRACE4(TRACE_TX_SCHEDULED, retcode, tx_readings, uplink_queue.Count(), tx_toa);
     memset(tx_buffer, 0, sizeof(tx_buffer));
 }
 
+/**
+ * Calls send_message at the earliest instant the duty cycle budget and the
+ * stack backoff allow, replacing any send already scheduled
+ */
+static void schedule_send()
+{
+    uint32_t delay = tx_scheduler.Delay();
+
+    if (send_event != 0) {
+        ev_monitor.Cancel(send_event);
+        send_event = 0;
+    }
+
+    if (delay == 0) {
+        send_message();
+        return;
+    }
+
+    APP_TRACE1(TRACE_NEXT_UPLINK, delay);
+    send_event = ev_monitor.CallIn(delay, QUEUE_EVENT_SEND, send_message);
+}
+
+/**
+ * Answers the requests of the shell thread, runs on ev_queue so it never
+ * races the stack callbacks over the queue, session or scheduler
+ */
+/**
+ * Store a value the shell set, the shell never writes device_config itself
+ * as the stack and the scheduler read it on this thread
+ */
+static bool write_config(const shell_request& request)
+{
+    if (request.Length < 3) {
+        return false;
+    }
+
+    uint16_t offset = request.Data[0] | (request.Data[1] << 8);
+    uint8_t length = request.Length - 3;
+    if (offset + length > sizeof(device_config)) {
+        return false;
+    }
+
+    memcpy((uint8_t*) &device_config + offset, request.Data + 3, length);
+    mark_dirty(request.Data[2]);
+    return true;
+}
+
+static void serve_shell()
+{
+    shell_request request;
+    shell_response response;
+
+    while (shell_mailbox.Take(request)) {
+        memset(&response, 0, sizeof(response));
+        response.Command = request.Command;
+
+        switch (request.Command) {
+            case ShellMailbox::RUN:
+                if (command_mode) {
+                    // cleared before the reply, the shell never sees it set
+                    // once the stack starts
+                    command_mode = false;
+                    ev_queue.break_dispatch();
+                }
+                break;
+            case ShellMailbox::STATUS:
+                response.Values[0] = connected;
+                response.Values[1] = tx_pending;
+                response.Values[2] = tx_scheduler.Delay();
+                response.Values[3] = join_retry.Attempts();
+                response.Values[4] = tx_retry.Attempts();
+                break;
+            case ShellMailbox::QUEUE_STATUS:
+                response.Values[0] = uplink_queue.Count();
+                response.Values[1] = uplink_queue.Capacity();
+                response.Values[2] = uplink_queue.Dropped();
+                response.Values[3] = uplink_queue.Policy() == UplinkQueue::DROP_OLDEST;
+                break;
+            case ShellMailbox::QUEUE_CLEAR:
+                response.Status = uplink_queue.Clear() ? 0 : -1;
+                break;
+            case ShellMailbox::CONFIG_WRITE:
+                response.Status = write_config(request) ? 0 : -1;
+                break;
+            case ShellMailbox::SEND_NOW:
+                if (connected) {
+                    if (uplink_queue.Count() == 0) {
+                        sample_sensor();
+                    }
+                    schedule_send();
+                } else {
+                    response.Status = -1;
+                }
+                break;
+            default:
+                response.Status = -1;
+                break;
+        }
+
+        shell_mailbox.Reply(response);
+    }
+}
+
 /**
  * Receive a message from the Network Server
  */
@@ -279,20 +717,22 @@ static void receive_message()
 {
     uint8_t port;
     int flags;
-    int16_t retcode = lorawan.receive(rx_buffer, sizeof(rx_buffer), port, flags);
+    int16_t retcode = lorawan.receive(downlinks.Buffer(), DownlinkDispatcher::BufferSize, port, flags);
 
     if (retcode < 0) {
-        printf("\r\n receive() - Error code %d \r\n", retcode);
+        APP_ERROR("receive() - Error code %d", retcode);
         return;
     }
 
-    printf(" RX Data on port %u (%d bytes): ", port, retcode);
-    for (uint8_t i = 0; i < retcode; i++) {
-        printf("%02x ", rx_buffer[i]);
-    }
-    printf("\r\n");
+    downlinks.Dispatch(port, retcode, flags);
+}
 
-    memset(rx_buffer, 0, sizeof(rx_buffer));
+/**
+ * Downlinks on ports without a handler
+ */
+static void unhandled_downlink(const downlink_payload& payload)
+{
+    printf(" RX Data on port %u (%u bytes)\r\n", payload.Port, payload.Length);
 }
 
 static uint8_t lora_battery_handler(void) {
@@ -304,51 +744,88 @@ static uint8_t lora_battery_handler(void) {
  */
 static void lora_event_handler(lorawan_event_t event)
 {
+    PROFILE_SCOPE(PROFILE_EVENT_HANDLER);
+
     switch (event) {
         case CONNECTED:
             printf("\r\n Connection - Successful \r\n");
-            send_message();
+            connected = true;
+            join_retry.Reset();
 
-            if (!device_config.app_settings.DutyCycleEnabled) {
-                ev_queue.call_every(device_config.app_settings.TxInterval, send_message);
+            if (uplink_queue.Count() == 0) {
+                sample_sensor();
             }
-
+            send_message();
             break;
         case DISCONNECTED:
+            connected = false;
             ev_queue.break_dispatch();
             printf("\r\n Disconnected Successfully \r\n");
             break;
         case TX_DONE:
-            printf("\r\n Message Sent to Network Server \r\n");
+            // for confirmed messages TX_DONE is only reported once the ACK arrived
+            APP_TRACE0(TRACE_MESSAGE_SENT);
+            uplink_queue.Pop(tx_first, tx_readings);
+            tx_readings = 0;
+            tx_pending = false;
+            tx_retry.Reset();
+
+            {
+                lorawan_tx_metadata metadata;
+                if (lorawan.get_tx_metadata(metadata) == LORAWAN_STATUS_OK && !metadata.stale) {
+                    if (device_config.settings.EnableADR) {
+                        tx_datarate = metadata.data_rate;
+                    }
+                    tx_scheduler.TxDone(metadata.channel, metadata.tx_toa ? metadata.tx_toa : tx_toa);
+                    device_config.session.Datarate = metadata.data_rate;
+                } else {
+                    tx_scheduler.TxDone(0, tx_toa);
+                }
+            }
+
+            // drain the backlog as fast as the duty cycle allows
             if (device_config.app_settings.DutyCycleEnabled) {
-                send_message();
+                schedule_send();
             }
             break;
         case TX_TIMEOUT:
         case TX_ERROR:
         case TX_CRYPTO_ERROR:
         case TX_SCHEDULING_ERROR:
-            printf("\r\n Transmission Error - EventCode = %d \r\n", event);
-            // try again
+            // the readings stay queued, try again once the backoff expired
+            tx_readings = 0;
+            tx_pending = false;
+            {
+                uint32_t delay = tx_retry.Next();
+                APP_TRACE3(TRACE_TX_ERROR, event, tx_retry.Attempts(), delay);
+                tx_scheduler.Backoff(delay);
+            }
             if (device_config.app_settings.DutyCycleEnabled) {
-                send_message();
+                schedule_send();
             }
             break;
         case RX_DONE:
-            printf("\r\n Received message from Network Server \r\n");
+            APP_TRACE0(TRACE_MESSAGE_RECEIVED);
             receive_message();
             break;
         case RX_TIMEOUT:
         case RX_ERROR:
-            printf("\r\n Error in reception - Code = %d \r\n", event);
+            APP_TRACE1(TRACE_RX_ERROR, event);
             break;
         case JOIN_FAILURE:
-            printf("\r\n OTAA Failed - Check Keys \r\n");
+            {
+                uint32_t delay = join_retry.Next();
+                APP_TRACE2(TRACE_JOIN_FAILED, join_retry.Attempts(), delay);
+                ev_monitor.CallIn(delay, QUEUE_EVENT_JOIN, join);
+            }
             break;
         case UPLINK_REQUIRED:
-            printf("\r\n Uplink required by NS \r\n");
+            APP_TRACE0(TRACE_UPLINK_REQUIRED);
             if (device_config.app_settings.DutyCycleEnabled) {
-                send_message();
+                if (uplink_queue.Count() == 0) {
+                    sample_sensor();
+                }
+                schedule_send();
             }
             break;
         default:
@@ -0,0 +1,194 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "payload_encoder.h"
+
+PayloadWriter::PayloadWriter(uint8_t* buffer, uint16_t size)
+:   _buffer(buffer),
+    _size(size),
+    _length(0),
+    _overflow(false)
+{
+}
+
+bool PayloadWriter::Reserve(uint16_t length) {
+    if (_overflow || length > _size - _length) {
+        _overflow = true;
+        return false;
+    }
+    return true;
+}
+
+bool PayloadWriter::PutByte(uint8_t value) {
+    if (!Reserve(1)) {
+        return false;
+    }
+    _buffer[_length++] = value;
+    return true;
+}
+
+bool PayloadWriter::PutUint16(uint16_t value) {
+    if (!Reserve(2)) {
+        return false;
+    }
+    _buffer[_length++] = value >> 8;
+    _buffer[_length++] = value;
+    return true;
+}
+
+bool PayloadWriter::PutUint32(uint32_t value) {
+    if (!Reserve(4)) {
+        return false;
+    }
+    _buffer[_length++] = value >> 24;
+    _buffer[_length++] = value >> 16;
+    _buffer[_length++] = value >> 8;
+    _buffer[_length++] = value;
+    return true;
+}
+
+uint8_t PayloadWriter::VarintSize(uint32_t value) {
+    uint8_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+bool PayloadWriter::PutVarint(uint32_t value) {
+    if (!Reserve(VarintSize(value))) {
+        return false;
+    }
+    while (value >= 0x80) {
+        _buffer[_length++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    _buffer[_length++] = value;
+    return true;
+}
+
+bool PayloadWriter::PutSignedVarint(int32_t value) {
+    return PutVarint(ZigZag(value));
+}
+
+void PayloadWriter::Truncate(uint16_t length) {
+    if (length < _length) {
+        _length = length;
+    }
+    _overflow = false;
+}
+
+CayenneLPP::CayenneLPP(PayloadWriter& writer)
+:   _writer(writer)
+{
+}
+
+bool CayenneLPP::Add8(uint8_t channel, uint8_t type, uint8_t value) {
+    if (_writer.Remaining() < 3) {
+        return false;
+    }
+    return _writer.PutByte(channel) && _writer.PutByte(type) && _writer.PutByte(value);
+}
+
+bool CayenneLPP::Add16(uint8_t channel, uint8_t type, uint16_t value) {
+    if (_writer.Remaining() < 4) {
+        return false;
+    }
+    return _writer.PutByte(channel) && _writer.PutByte(type) && _writer.PutUint16(value);
+}
+
+bool CayenneLPP::AddDigitalInput(uint8_t channel, uint8_t value) {
+    return Add8(channel, DIGITAL_INPUT, value);
+}
+
+bool CayenneLPP::AddDigitalOutput(uint8_t channel, uint8_t value) {
+    return Add8(channel, DIGITAL_OUTPUT, value);
+}
+
+bool CayenneLPP::AddAnalogInput(uint8_t channel, int16_t hundredths) {
+    return Add16(channel, ANALOG_INPUT, hundredths);
+}
+
+bool CayenneLPP::AddAnalogOutput(uint8_t channel, int16_t hundredths) {
+    return Add16(channel, ANALOG_OUTPUT, hundredths);
+}
+
+bool CayenneLPP::AddLuminosity(uint8_t channel, uint16_t lux) {
+    return Add16(channel, LUMINOSITY, lux);
+}
+
+bool CayenneLPP::AddPresence(uint8_t channel, uint8_t value) {
+    return Add8(channel, PRESENCE, value);
+}
+
+bool CayenneLPP::AddTemperature(uint8_t channel, int16_t tenths) {
+    return Add16(channel, TEMPERATURE, tenths);
+}
+
+bool CayenneLPP::AddRelativeHumidity(uint8_t channel, uint8_t half_percent) {
+    return Add8(channel, RELATIVE_HUMIDITY, half_percent);
+}
+
+bool CayenneLPP::AddBarometricPressure(uint8_t channel, uint16_t tenths_hpa) {
+    return Add16(channel, BAROMETRIC_PRESSURE, tenths_hpa);
+}
+
+TimeSeriesEncoder::TimeSeriesEncoder(PayloadWriter& writer)
+:   _writer(writer),
+    _timestamp(0),
+    _value(0)
+{
+}
+
+bool TimeSeriesEncoder::Begin(uint8_t sensor, uint32_t timestamp) {
+    _timestamp = timestamp;
+    _value = 0;
+
+    if (_writer.Remaining() < 2 + PayloadWriter::VarintSize(timestamp)) {
+        return false;
+    }
+    return _writer.PutByte(Format) && _writer.PutByte(sensor) && _writer.PutVarint(timestamp);
+}
+
+bool TimeSeriesEncoder::Add(uint32_t timestamp, int32_t value) {
+    int32_t dt = (int32_t) (timestamp - _timestamp);
+    int32_t dv = (int32_t) ((uint32_t) value - (uint32_t) _value);
+
+    // all or nothing, a reading is never split across frames
+    if (_writer.Remaining() < PayloadWriter::VarintSize(PayloadWriter::ZigZag(dt))
+                              + PayloadWriter::VarintSize(PayloadWriter::ZigZag(dv))) {
+        return false;
+    }
+
+    _writer.PutSignedVarint(dt);
+    _writer.PutSignedVarint(dv);
+    _timestamp = timestamp;
+    _value = value;
+    return true;
+}
@@ -0,0 +1,149 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_PAYLOAD_ENCODER__
+#define __MTS_PAYLOAD_ENCODER__
+
+#include <stdint.h>
+
+/**
+ * Bounds checked writer over a caller supplied buffer. Once a put does not
+ * fit the writer stays in the overflow state and the buffer is left as it
+ * was before that put. No heap is used.
+ */
+class PayloadWriter {
+
+    public:
+
+        PayloadWriter(uint8_t* buffer, uint16_t size);
+
+        bool PutByte(uint8_t value);
+        bool PutUint16(uint16_t value);         // big endian
+        bool PutUint32(uint32_t value);         // big endian
+        bool PutVarint(uint32_t value);         // LEB128
+        bool PutSignedVarint(int32_t value);    // zig-zag then LEB128
+
+        /**
+         * Drop everything written after length, used to back out a partly
+         * written entry.
+         */
+        void Truncate(uint16_t length);
+
+        uint16_t Length() const { return _length; }
+        uint16_t Remaining() const { return _size - _length; }
+        bool Overflow() const { return _overflow; }
+        const uint8_t* Data() const { return _buffer; }
+
+        static uint32_t ZigZag(int32_t value) { return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31); }
+        static uint8_t VarintSize(uint32_t value);
+
+    private:
+
+        bool Reserve(uint16_t length);
+
+        uint8_t* _buffer;
+        uint16_t _size;
+        uint16_t _length;
+        bool _overflow;
+};
+
+/**
+ * CayenneLPP frame builder. Each entry is channel, type and a big endian
+ * value scaled as the LPP specification requires.
+ */
+class CayenneLPP {
+
+    public:
+
+        enum Type {
+            DIGITAL_INPUT       = 0,
+            DIGITAL_OUTPUT      = 1,
+            ANALOG_INPUT        = 2,
+            ANALOG_OUTPUT       = 3,
+            LUMINOSITY          = 101,
+            PRESENCE            = 102,
+            TEMPERATURE         = 103,
+            RELATIVE_HUMIDITY   = 104,
+            BAROMETRIC_PRESSURE = 115
+        };
+
+        CayenneLPP(PayloadWriter& writer);
+
+        bool AddDigitalInput(uint8_t channel, uint8_t value);
+        bool AddDigitalOutput(uint8_t channel, uint8_t value);
+        bool AddAnalogInput(uint8_t channel, int16_t hundredths);
+        bool AddAnalogOutput(uint8_t channel, int16_t hundredths);
+        bool AddLuminosity(uint8_t channel, uint16_t lux);
+        bool AddPresence(uint8_t channel, uint8_t value);
+        bool AddTemperature(uint8_t channel, int16_t tenths);
+        bool AddRelativeHumidity(uint8_t channel, uint8_t half_percent);
+        bool AddBarometricPressure(uint8_t channel, uint16_t tenths_hpa);
+
+    private:
+
+        bool Add8(uint8_t channel, uint8_t type, uint8_t value);
+        bool Add16(uint8_t channel, uint8_t type, uint16_t value);
+
+        PayloadWriter& _writer;
+};
+
+/**
+ * Delta encoded time series of one sensor.
+ *
+ * Frame layout:
+ *   0     format (0x02)
+ *   1     sensor
+ *   2-    base timestamp, varint
+ *   then per reading:
+ *         time since the previous reading, zig-zag varint
+ *         value change since the previous reading, zig-zag varint
+ *
+ * The first reading is relative to the base timestamp and a value of 0.
+ */
+class TimeSeriesEncoder {
+
+    public:
+
+        static const uint8_t Format = 0x02;
+
+        TimeSeriesEncoder(PayloadWriter& writer);
+
+        /**
+         * Start a frame. Must be called before the first Add().
+         */
+        bool Begin(uint8_t sensor, uint32_t timestamp);
+        bool Add(uint32_t timestamp, int32_t value);
+
+    private:
+
+        PayloadWriter& _writer;
+        uint32_t _timestamp;
+        int32_t _value;
+};
+
+#endif
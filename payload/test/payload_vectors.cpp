@@ -0,0 +1,213 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+/*
+ * Host program writing encoder test vectors for tools/test_payload.py.
+ * Not part of the firmware, payload/.mbedignore keeps it out of the build.
+ *
+ * One vector per line:
+ *   varint <hex> <value>
+ *   svarint <hex> <value>
+ *   lpp <hex> <channel>:<type>:<raw> ...
+ *   series <hex> <sensor> <base> <timestamp>:<value> ...
+ *
+ * Checks that need no decoder, overflow handling, are done here and make
+ * the program exit with 1.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "payload_encoder.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static void print_hex(const char* kind, const PayloadWriter& writer) {
+    printf("%s ", kind);
+    for (uint16_t i = 0; i < writer.Length(); i++) {
+        printf("%02x", writer.Data()[i]);
+    }
+}
+
+static void varint_vectors() {
+    static const uint32_t values[] = {
+        0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, 0x1FFFFF, 0x200000, 0xFFFFFFF, 0x10000000, 0xFFFFFFFF
+    };
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint8_t buffer[8];
+        PayloadWriter writer(buffer, sizeof(buffer));
+        CHECK(writer.PutVarint(values[i]));
+        CHECK(writer.Length() == PayloadWriter::VarintSize(values[i]));
+        print_hex("varint", writer);
+        printf(" %lu\n", (unsigned long) values[i]);
+    }
+}
+
+static void signed_varint_vectors() {
+    static const int32_t values[] = {
+        0, -1, 1, -64, 63, -65, 64, -8192, 8191, 2147483647, -2147483647 - 1
+    };
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint8_t buffer[8];
+        PayloadWriter writer(buffer, sizeof(buffer));
+        CHECK(writer.PutSignedVarint(values[i]));
+        print_hex("svarint", writer);
+        printf(" %ld\n", (long) values[i]);
+    }
+
+    CHECK(PayloadWriter::ZigZag(0) == 0);
+    CHECK(PayloadWriter::ZigZag(-1) == 1);
+    CHECK(PayloadWriter::ZigZag(1) == 2);
+    CHECK(PayloadWriter::ZigZag(2147483647) == 0xFFFFFFFE);
+    CHECK(PayloadWriter::ZigZag(-2147483647 - 1) == 0xFFFFFFFF);
+}
+
+static void lpp_vectors() {
+    uint8_t buffer[64];
+
+    // minimum of every type
+    {
+        PayloadWriter writer(buffer, sizeof(buffer));
+        CayenneLPP lpp(writer);
+        CHECK(lpp.AddDigitalInput(1, 0));
+        CHECK(lpp.AddDigitalOutput(2, 0));
+        CHECK(lpp.AddAnalogInput(3, -32768));
+        CHECK(lpp.AddAnalogOutput(4, -32768));
+        CHECK(lpp.AddLuminosity(5, 0));
+        CHECK(lpp.AddPresence(6, 0));
+        CHECK(lpp.AddTemperature(7, -32768));
+        CHECK(lpp.AddRelativeHumidity(8, 0));
+        CHECK(lpp.AddBarometricPressure(9, 0));
+        print_hex("lpp", writer);
+        printf(" 1:0:0 2:1:0 3:2:-32768 4:3:-32768 5:101:0 6:102:0 7:103:-32768 8:104:0 9:115:0\n");
+    }
+
+    // maximum of every type
+    {
+        PayloadWriter writer(buffer, sizeof(buffer));
+        CayenneLPP lpp(writer);
+        CHECK(lpp.AddDigitalInput(1, 255));
+        CHECK(lpp.AddDigitalOutput(2, 255));
+        CHECK(lpp.AddAnalogInput(3, 32767));
+        CHECK(lpp.AddAnalogOutput(4, 32767));
+        CHECK(lpp.AddLuminosity(5, 65535));
+        CHECK(lpp.AddPresence(6, 255));
+        CHECK(lpp.AddTemperature(7, 32767));
+        CHECK(lpp.AddRelativeHumidity(8, 255));
+        CHECK(lpp.AddBarometricPressure(9, 65535));
+        print_hex("lpp", writer);
+        printf(" 1:0:255 2:1:255 3:2:32767 4:3:32767 5:101:65535 6:102:255 7:103:32767 8:104:255 9:115:65535\n");
+    }
+
+    // an entry that does not fit leaves the frame as it was
+    {
+        PayloadWriter writer(buffer, 7);
+        CayenneLPP lpp(writer);
+        CHECK(lpp.AddTemperature(3, -1));
+        CHECK(!lpp.AddTemperature(4, 1));
+        CHECK(writer.Length() == 4);
+        CHECK(lpp.AddPresence(5, 1));
+        print_hex("lpp", writer);
+        printf(" 3:103:-1 5:102:1\n");
+    }
+}
+
+static void series_vectors() {
+    static const struct {
+            uint32_t Timestamp;
+            int32_t Value;
+    } readings[] = {
+        { 1600000000, 0 },
+        { 1600000000, -1 },
+        { 1600000060, 2147483647 },
+        { 1599999940, -2147483647 - 1 },
+        { 1600000000, 2147483647 },
+        { 0xFFFFFFFF, 0 },
+        { 0, -32768 },
+        { 1, 32767 }
+    };
+    uint8_t buffer[128];
+    PayloadWriter writer(buffer, sizeof(buffer));
+    TimeSeriesEncoder series(writer);
+
+    CHECK(series.Begin(7, 1600000000));
+    for (size_t i = 0; i < sizeof(readings) / sizeof(readings[0]); i++) {
+        CHECK(series.Add(readings[i].Timestamp, readings[i].Value));
+    }
+
+    print_hex("series", writer);
+    printf(" 7 1600000000");
+    for (size_t i = 0; i < sizeof(readings) / sizeof(readings[0]); i++) {
+        printf(" %lu:%ld", (unsigned long) readings[i].Timestamp, (long) readings[i].Value);
+    }
+    printf("\n");
+
+    // a reading that does not fit is not split across frames
+    {
+        uint8_t small[8];
+        PayloadWriter bounded(small, sizeof(small));
+        TimeSeriesEncoder partial(bounded);
+
+        CHECK(partial.Begin(1, 0));
+        CHECK(partial.Add(1, 1));
+        CHECK(!partial.Add(0xFFFFFFF, 100000));
+        CHECK(bounded.Length() == 5);
+        print_hex("series", bounded);
+        printf(" 1 0 1:1\n");
+    }
+}
+
+static void writer_checks() {
+    uint8_t buffer[4];
+    PayloadWriter writer(buffer, sizeof(buffer));
+
+    CHECK(writer.PutUint16(0x1234));
+    CHECK(!writer.PutUint32(0x56789abc));
+    CHECK(writer.Overflow());
+    CHECK(writer.Length() == 2);
+    CHECK(!writer.PutByte(0));
+
+    writer.Truncate(1);
+    CHECK(!writer.Overflow());
+    CHECK(writer.Length() == 1);
+    CHECK(writer.PutUint16(0xabcd));
+    CHECK(buffer[0] == 0x12 && buffer[1] == 0xab && buffer[2] == 0xcd);
+}
+
+int main() {
+    varint_vectors();
+    signed_varint_vectors();
+    lpp_vectors();
+    series_vectors();
+    writer_checks();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,202 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "provisioning.h"
+#include "crc16.h"
+
+// tools/provision.py patches images at these offsets
+MBED_STATIC_ASSERT(sizeof(ProtectedSettings_t) == 256, "protected settings size changed");
+MBED_STATIC_ASSERT(sizeof(NetworkSettings_t) == 1024, "settings size changed");
+MBED_STATIC_ASSERT(offsetof(ProtectedSettings_t, DeviceEUI) == 1, "DeviceEUI moved");
+MBED_STATIC_ASSERT(offsetof(NetworkSettings_t, AppEUI) == 13, "AppEUI moved");
+MBED_STATIC_ASSERT(offsetof(NetworkSettings_t, AppKey) == 149, "AppKey moved");
+
+Provisioning::Provisioning(ConsoleRx& rx, ConsoleTx& tx, ConfigManager& config_mng, DeviceConfig_t& config)
+:   _rx(rx),
+    _tx(tx),
+    _config_mng(config_mng),
+    _config(config),
+    _frame((uint8_t*) _storage + 2),
+    _output_length(0)
+{
+}
+
+bool Provisioning::Run(uint32_t timeout) {
+    uint8_t input[64];
+    uint16_t length = 0;
+    bool escape = false;
+    bool overrun = false;
+
+    while (true) {
+        uint32_t count = _rx.Read(input, sizeof(input), timeout);
+        if (count == 0) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint8_t c = input[i];
+
+            if (c == End) {
+                if (!overrun && length > 0 && !Handle(length)) {
+                    return true;
+                }
+                length = 0;
+                escape = false;
+                overrun = false;
+                continue;
+            }
+
+            if (escape) {
+                c = (c == EscEnd) ? End : (c == EscEsc) ? Esc : c;
+                escape = false;
+            } else if (c == Esc) {
+                escape = true;
+                continue;
+            }
+
+            if (length < MaxFrame) {
+                _frame[length++] = c;
+            } else {
+                overrun = true;
+            }
+        }
+    }
+}
+
+bool Provisioning::Handle(uint16_t length) {
+    // command, sequence and crc at least
+    if (length < 4) {
+        return true;
+    }
+
+    uint16_t crc = _frame[length - 2] | (_frame[length - 1] << 8);
+    length -= 2;
+    if (crc16(_frame, length) != crc) {
+        return true;
+    }
+
+    uint8_t command = _frame[0];
+    uint8_t sequence = _frame[1];
+    uint8_t* payload = _frame + 2;
+    length -= 2;
+
+    switch (command) {
+        case PING: {
+            uint8_t info[5];
+            info[0] = Version;
+            info[1] = sizeof(ProtectedSettings_t) & 0xff;
+            info[2] = sizeof(ProtectedSettings_t) >> 8;
+            info[3] = sizeof(NetworkSettings_t) & 0xff;
+            info[4] = sizeof(NetworkSettings_t) >> 8;
+            Reply(command, sequence, OK, info, sizeof(info));
+            break;
+        }
+
+        case READ:
+            Reply(command, sequence, OK, &_config.provisioning, sizeof(_config.provisioning),
+                  &_config.settings, sizeof(_config.settings));
+            break;
+
+        case WRITE:
+            if (length != ImageSize) {
+                Reply(command, sequence, BAD_LENGTH);
+                break;
+            }
+
+            // the image stays in the frame buffer until it is stored, the
+            // running configuration only changes once it is
+            if (!_config_mng.SaveProvisioning(*(ProtectedSettings_t*) payload,
+                                              *(NetworkSettings_t*) (payload + sizeof(ProtectedSettings_t)))) {
+                Reply(command, sequence, SAVE_FAILED);
+                break;
+            }
+            memcpy(&_config.provisioning, payload, sizeof(_config.provisioning));
+            memcpy(&_config.settings, payload + sizeof(_config.provisioning), sizeof(_config.settings));
+            Reply(command, sequence, OK);
+            break;
+
+        case EXIT:
+            Reply(command, sequence, OK);
+            return false;
+
+        default:
+            Reply(command, sequence, UNKNOWN_COMMAND);
+            break;
+    }
+
+    return true;
+}
+
+void Provisioning::Reply(uint8_t command, uint8_t sequence, int8_t status,
+                         const void* data, uint16_t length, const void* more, uint16_t more_length) {
+    uint8_t header[3] = { (uint8_t) (command | 0x80), sequence, (uint8_t) status };
+    uint16_t crc = 0xFFFF;
+
+    Put(End);
+    Send(header, sizeof(header), crc);
+    Send((const uint8_t*) data, length, crc);
+    Send((const uint8_t*) more, more_length, crc);
+
+    uint8_t trailer[2] = { (uint8_t) (crc & 0xff), (uint8_t) (crc >> 8) };
+    uint16_t unused = 0;
+    Send(trailer, sizeof(trailer), unused);
+    Put(End);
+    FlushOutput();
+}
+
+void Provisioning::Send(const uint8_t* data, uint16_t length, uint16_t& crc) {
+    if (length == 0) {
+        return;
+    }
+
+    crc = crc16(data, length, crc);
+    for (uint16_t i = 0; i < length; i++) {
+        if (data[i] == End) {
+            Put(Esc);
+            Put(EscEnd);
+        } else if (data[i] == Esc) {
+            Put(Esc);
+            Put(EscEsc);
+        } else {
+            Put(data[i]);
+        }
+    }
+}
+
+void Provisioning::Put(uint8_t c) {
+    if (_output_length == sizeof(_output)) {
+        FlushOutput();
+    }
+    _output[_output_length++] = c;
+}
+
+void Provisioning::FlushOutput() {
+    // the shell thread is low priority, the console waits for room
+    _tx.write(_output, _output_length);
+    _output_length = 0;
+}
@@ -0,0 +1,115 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_PROVISIONING__
+#define __MTS_PROVISIONING__
+
+#include "mbed.h"
+#include "config.h"
+#include "console_rx.h"
+#include "console_tx.h"
+
+/**
+ * Binary factory provisioning over the console UART.
+ *
+ * Frames are SLIP encoded (END 0xC0, ESC 0xDB) and carry
+ *
+ *     request:  [command][sequence][payload...][crc16 LE]
+ *     response: [command | 0x80][sequence][status][payload...][crc16 LE]
+ *
+ * with the CRC16/CCITT-FALSE of everything before it. Frames with a bad
+ * CRC are dropped without a response, the host repeats the request.
+ *
+ * A WRITE carries a ProtectedSettings_t followed by a NetworkSettings_t and
+ * saves both through ConfigManager::SaveProvisioning. tools/provision.py
+ * is the host side.
+ */
+class Provisioning {
+
+    public:
+
+        static const uint8_t Version = 1;
+
+        enum Command {
+            PING = 0x01,        // response: version, protected and settings size LE16
+            READ = 0x02,        // response: current protected settings and settings
+            WRITE = 0x03,       // payload: protected settings and settings
+            EXIT = 0x04         // back to the text shell
+        };
+
+        enum Status {
+            OK = 0,
+            UNKNOWN_COMMAND = -1,
+            BAD_LENGTH = -2,
+            SAVE_FAILED = -3
+        };
+
+        Provisioning(ConsoleRx& rx, ConsoleTx& tx, ConfigManager& config_mng, DeviceConfig_t& config);
+
+        /**
+         * Serve requests until EXIT or timeout ms pass without one. Returns
+         * true if the host sent EXIT, false on timeout.
+         */
+        bool Run(uint32_t timeout);
+
+    private:
+
+        static const uint8_t End = 0xC0;
+        static const uint8_t Esc = 0xDB;
+        static const uint8_t EscEnd = 0xDC;
+        static const uint8_t EscEsc = 0xDD;
+
+        static const uint16_t ImageSize = sizeof(ProtectedSettings_t) + sizeof(NetworkSettings_t);
+        static const uint16_t MaxFrame = 2 + ImageSize + 2;
+
+        /**
+         * Handle a decoded frame, false once the host asked to exit
+         */
+        bool Handle(uint16_t length);
+
+        void Reply(uint8_t command, uint8_t sequence, int8_t status,
+                   const void* data = NULL, uint16_t length = 0, const void* more = NULL, uint16_t more_length = 0);
+
+        void Send(const uint8_t* data, uint16_t length, uint16_t& crc);
+        void Put(uint8_t c);
+        void FlushOutput();
+
+        ConsoleRx& _rx;
+        ConsoleTx& _tx;
+        ConfigManager& _config_mng;
+        DeviceConfig_t& _config;
+
+        // decoded frame, starts 2 bytes into word aligned storage so the
+        // payload after command and sequence is aligned for the settings
+        uint32_t _storage[(2 + MaxFrame + 3) / 4];
+        uint8_t* _frame;
+        uint8_t _output[64];
+        uint8_t _output_length;
+};
+
+#endif
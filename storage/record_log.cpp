@@ -0,0 +1,230 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "record_log.h"
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+
+RecordLog::RecordLog(ConfigManager& config)
+:   _config(config),
+    _head(0),
+    _tail(0),
+    _open(false)
+{
+    memset(&_header, 0, sizeof(_header));
+    _file.fd = -1;
+}
+
+RecordLog::~RecordLog() {
+    Close();
+}
+
+bool RecordLog::Open(const char* name, uint16_t record_size, uint16_t capacity) {
+    if (_open || record_size == 0 || record_size > MaxRecordSize || capacity == 0) {
+        return false;
+    }
+
+    _header.Magic = Magic;
+    _header.RecordSize = record_size;
+    _header.Capacity = capacity;
+    _header.TailSequence = 0;
+
+    _file = _config.OpenUserFile(name, SPIFFS_RDWR);
+    if (_file.fd >= 0) {
+        Header stored;
+        if (_file.size == sizeof(Header) + capacity * SlotSize()
+                && _config.ReadUserFile(_file, &stored, sizeof(stored)) == sizeof(stored)
+                && stored.Magic == Magic
+                && stored.RecordSize == record_size
+                && stored.Capacity == capacity) {
+            _header.TailSequence = stored.TailSequence;
+            _open = true;
+        } else {
+            printf("Record log %s has a different layout, recreating", name);
+            _config.CloseUserFile(_file);
+        }
+    }
+
+    if (!_open && !Create(name)) {
+        return false;
+    }
+    _open = true;
+
+    if (!Scan()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void RecordLog::Close() {
+    if (_open) {
+        if (_tail != _header.TailSequence) {
+            WriteHeader();
+        }
+        _config.CloseUserFile(_file);
+        _open = false;
+    }
+    _file.fd = -1;
+}
+
+bool RecordLog::Create(const char* name) {
+    _file = _config.OpenUserFile(name, SPIFFS_CREAT | SPIFFS_RDWR | SPIFFS_TRUNC);
+    if (_file.fd < 0) {
+        return false;
+    }
+
+    if (_config.WriteUserFile(_file, &_header, sizeof(_header)) != sizeof(_header)) {
+        _config.CloseUserFile(_file);
+        return false;
+    }
+
+    // erased slots read back as EmptySequence
+    uint8_t fill[PAGE_SIZE];
+    memset(fill, 0xFF, sizeof(fill));
+
+    uint32_t remaining = _header.Capacity * SlotSize();
+    while (remaining > 0) {
+        uint32_t chunk = remaining < sizeof(fill) ? remaining : sizeof(fill);
+        if (_config.WriteUserFile(_file, fill, chunk) != (int) chunk) {
+            _config.CloseUserFile(_file);
+            return false;
+        }
+        remaining -= chunk;
+    }
+
+    if (!_config.FlushUserFile(_file)) {
+        _config.CloseUserFile(_file);
+        return false;
+    }
+    return true;
+}
+
+bool RecordLog::Scan() {
+    bool found = false;
+    uint32_t newest = 0;
+
+    for (uint32_t slot = 0; slot < _header.Capacity; slot++) {
+        uint32_t sequence;
+        uint32_t offset = sizeof(Header) + slot * SlotSize() + _header.RecordSize;
+
+        if (!_config.SeekUserFile(_file, offset, SPIFFS_SEEK_SET)
+                || _config.ReadUserFile(_file, &sequence, sizeof(sequence)) != sizeof(sequence)) {
+            return false;
+        }
+
+        if (sequence != EmptySequence && sequence % _header.Capacity == slot
+                && (!found || sequence > newest)) {
+            newest = sequence;
+            found = true;
+        }
+    }
+
+    _head = found ? newest + 1 : 0;
+    _tail = _header.TailSequence;
+
+    if (_tail > _head) {
+        _tail = _head;
+    }
+    if (_head - _tail > _header.Capacity) {
+        _tail = _head - _header.Capacity;
+    }
+    return true;
+}
+
+uint32_t RecordLog::SlotOffset(uint32_t sequence) const {
+    return sizeof(Header) + (sequence % _header.Capacity) * SlotSize();
+}
+
+bool RecordLog::Append(const void* record) {
+    if (!_open) {
+        return false;
+    }
+
+    // payload first, sequence last, so an interrupted write keeps the old sequence
+    if (!_config.SeekUserFile(_file, SlotOffset(_head), SPIFFS_SEEK_SET)
+            || _config.WriteUserFile(_file, (void*) record, _header.RecordSize) != _header.RecordSize
+            || _config.WriteUserFile(_file, &_head, sizeof(_head)) != sizeof(_head)
+            || !_config.FlushUserFile(_file)) {
+        return false;
+    }
+
+    _head++;
+    if (_head - _tail > _header.Capacity) {
+        _tail = _head - _header.Capacity;
+    }
+    return true;
+}
+
+bool RecordLog::Read(uint32_t index, void* record) {
+    if (!_open || index >= Count()) {
+        return false;
+    }
+
+    uint32_t expected = _tail + index;
+    uint32_t sequence;
+
+    if (!_config.SeekUserFile(_file, SlotOffset(expected), SPIFFS_SEEK_SET)
+            || _config.ReadUserFile(_file, record, _header.RecordSize) != _header.RecordSize
+            || _config.ReadUserFile(_file, &sequence, sizeof(sequence)) != sizeof(sequence)) {
+        return false;
+    }
+
+    return sequence == expected;
+}
+
+bool RecordLog::Consume(uint32_t count) {
+    if (!_open) {
+        return false;
+    }
+
+    _tail += count < Count() ? count : Count();
+    if (_tail - _header.TailSequence < TailSyncInterval) {
+        return true;
+    }
+    return WriteHeader();
+}
+
+bool RecordLog::Clear() {
+    if (!_open) {
+        return false;
+    }
+
+    _tail = _head;
+    return WriteHeader();
+}
+
+bool RecordLog::WriteHeader() {
+    _header.TailSequence = _tail;
+
+    return _config.SeekUserFile(_file, 0, SPIFFS_SEEK_SET)
+           && _config.WriteUserFile(_file, &_header, sizeof(_header)) == sizeof(_header)
+           && _config.FlushUserFile(_file);
+}
+
+#endif /* TARGET_MTS_MDOT_F411RE */
@@ -0,0 +1,131 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_RECORD_LOG__
+#define __MTS_RECORD_LOG__
+
+#include "mbed.h"
+#include "config.h"
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+
+/**
+ * Circular log of fixed size records kept in a SPIFFS user file.
+ *
+ * The file is preallocated when the log is created so it never grows, but
+ * SPIFFS can't rewrite a page in place: every write to a slot programs a new
+ * data page and index page and leaves the old ones for garbage collection.
+ * Each slot carries a sequence number written after the payload, which lets
+ * Open() find the head again after a reset and lets a torn write be
+ * detected.
+ *
+ * The tail (oldest record not yet consumed) is kept in the file header, but
+ * only written once it moved TailSyncInterval records, on Clear() and on
+ * Close(), so consuming records rarely costs a write. After a reset the
+ * last consumed records, up to TailSyncInterval, are read again.
+ *
+ * Not thread safe, callers must serialize access to a log.
+ */
+class RecordLog {
+
+    public:
+
+        static const uint16_t MaxRecordSize = 128;
+
+        /**
+         * Records consumed before the tail is written to the header
+         */
+        static const uint32_t TailSyncInterval = 16;
+
+        RecordLog(ConfigManager& config);
+        ~RecordLog();
+
+        /**
+         * Open the log, creating or recreating the file if it does not
+         * match the requested geometry.
+         */
+        bool Open(const char* name, uint16_t record_size, uint16_t capacity);
+        void Close();
+
+        /**
+         * Append a record of RecordSize() bytes. When the log is full the
+         * oldest record is overwritten.
+         */
+        bool Append(const void* record);
+
+        /**
+         * Read the record at index, 0 being the oldest unconsumed record.
+         */
+        bool Read(uint32_t index, void* record);
+
+        /**
+         * Drop the oldest count records. The header is only written once
+         * TailSyncInterval records were dropped since it was last written.
+         */
+        bool Consume(uint32_t count);
+        bool Clear();
+
+        uint32_t Count() const { return _head - _tail; }
+
+        /**
+         * Sequence number of the oldest unconsumed record
+         */
+        uint32_t Tail() const { return _tail; }
+        uint16_t Capacity() const { return _header.Capacity; }
+        uint16_t RecordSize() const { return _header.RecordSize; }
+        bool IsOpen() const { return _open; }
+
+    private:
+
+        static const uint32_t Magic = 0x524c4f47;    // "RLOG"
+        static const uint32_t EmptySequence = 0xFFFFFFFF;
+
+        typedef struct {
+                uint32_t Magic;
+                uint16_t RecordSize;
+                uint16_t Capacity;
+                uint32_t TailSequence;
+        } Header;
+
+        bool Create(const char* name);
+        bool Scan();
+        bool WriteHeader();
+        uint32_t SlotOffset(uint32_t sequence) const;
+        uint32_t SlotSize() const { return _header.RecordSize + sizeof(uint32_t); }
+
+        ConfigManager& _config;
+        file_record _file;
+        Header _header;
+        uint32_t _head;         // sequence number of the next record
+        uint32_t _tail;         // sequence number of the oldest record
+        bool _open;
+};
+
+#endif /* TARGET_MTS_MDOT_F411RE */
+
+#endif
@@ -0,0 +1,172 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "uplink_queue.h"
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+char UplinkQueue::file[] = "uplink.q";
+
+UplinkQueue::UplinkQueue(ConfigManager& config, uint16_t capacity, DropPolicy policy)
+:   _capacity(capacity),
+    _policy(policy),
+    _dropped(0),
+    _log(config)
+{
+}
+
+bool UplinkQueue::Open() {
+    if (!_log.Open(file, sizeof(sensor_reading), _capacity)) {
+        printf("Failed to open uplink queue");
+        return false;
+    }
+    return true;
+}
+
+void UplinkQueue::Close() {
+    _log.Close();
+}
+
+bool UplinkQueue::Push(const sensor_reading& reading) {
+    if (_log.Count() >= _capacity) {
+        _dropped++;
+        if (_policy == DROP_NEWEST) {
+            return false;
+        }
+        // RecordLog overwrites the oldest record on its own
+    }
+    return _log.Append(&reading);
+}
+
+bool UplinkQueue::Peek(uint32_t index, sensor_reading& reading) {
+    return _log.Read(index, &reading);
+}
+
+uint32_t UplinkQueue::Tail() const {
+    return _log.Tail();
+}
+
+bool UplinkQueue::Pop(uint32_t first, uint32_t count) {
+    uint32_t end = first + count;
+    uint32_t tail = _log.Tail();
+
+    if ((int32_t) (end - tail) <= 0) {
+        return true;
+    }
+    return _log.Consume(end - tail);
+}
+
+bool UplinkQueue::Discard() {
+    _dropped++;
+    return _log.Consume(1);
+}
+
+bool UplinkQueue::Clear() {
+    return _log.Clear();
+}
+
+uint32_t UplinkQueue::Count() {
+    return _log.Count();
+}
+#else
+UplinkQueue::UplinkQueue(ConfigManager& config, uint16_t capacity, DropPolicy policy)
+:   _capacity(capacity < MBED_CONF_APP_UPLINK_QUEUE_SIZE ? capacity : MBED_CONF_APP_UPLINK_QUEUE_SIZE),
+    _policy(policy),
+    _dropped(0),
+    _head(0),
+    _count(0),
+    _tail(0)
+{
+}
+
+bool UplinkQueue::Open() {
+    return true;
+}
+
+void UplinkQueue::Close() {
+}
+
+bool UplinkQueue::Push(const sensor_reading& reading) {
+    if (_count >= _capacity) {
+        _dropped++;
+        if (_policy == DROP_NEWEST) {
+            return false;
+        }
+        _head = (_head + 1) % _capacity;
+        _count--;
+        _tail++;
+    }
+    _readings[(_head + _count) % _capacity] = reading;
+    _count++;
+    return true;
+}
+
+bool UplinkQueue::Peek(uint32_t index, sensor_reading& reading) {
+    if (index >= _count) {
+        return false;
+    }
+    reading = _readings[(_head + index) % _capacity];
+    return true;
+}
+
+uint32_t UplinkQueue::Tail() const {
+    return _tail;
+}
+
+bool UplinkQueue::Pop(uint32_t first, uint32_t count) {
+    uint32_t end = first + count;
+
+    if ((int32_t) (end - _tail) <= 0) {
+        return true;
+    }
+
+    count = end - _tail;
+    if (count > _count) {
+        count = _count;
+    }
+    _head = (_head + count) % _capacity;
+    _count -= count;
+    _tail += count;
+    return true;
+}
+
+bool UplinkQueue::Discard() {
+    _dropped++;
+    return Pop(_tail, 1);
+}
+
+bool UplinkQueue::Clear() {
+    _tail += _count;
+    _head = 0;
+    _count = 0;
+    return true;
+}
+
+uint32_t UplinkQueue::Count() {
+    return _count;
+}
+#endif /* TARGET_MTS_MDOT_F411RE */
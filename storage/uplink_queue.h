@@ -0,0 +1,120 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_UPLINK_QUEUE__
+#define __MTS_UPLINK_QUEUE__
+
+#include "mbed.h"
+#include "config.h"
+#include "record_log.h"
+
+typedef struct {
+        uint32_t Timestamp;     // time epoch in the top 8 bits, seconds into it in the low 24
+        int16_t Value;          // reading in tenths of a unit
+        uint8_t Sensor;
+        uint8_t Flags;
+} sensor_reading;
+
+/**
+ * Bounded FIFO of sensor readings waiting to be sent.
+ *
+ * On the mDot the queue is a RecordLog in the user file system, so readings
+ * survive a reset; as the log saves its tail lazily, up to
+ * RecordLog::TailSyncInterval readings already sent may be sent again after
+ * one. Other targets keep the queue in RAM.
+ */
+class UplinkQueue {
+
+    public:
+
+        enum DropPolicy {
+            DROP_OLDEST,
+            DROP_NEWEST
+        };
+
+        UplinkQueue(ConfigManager& config, uint16_t capacity, DropPolicy policy);
+
+        bool Open();
+        void Close();
+
+        /**
+         * Queue a reading. When the queue is full the configured drop
+         * policy decides whether the oldest or the new reading is lost.
+         */
+        bool Push(const sensor_reading& reading);
+
+        /**
+         * Copy the reading at index, 0 being the oldest.
+         */
+        bool Peek(uint32_t index, sensor_reading& reading);
+
+        /**
+         * Sequence number of the oldest reading, it increases by one for
+         * every reading removed from the queue, dropped ones included.
+         */
+        uint32_t Tail() const;
+
+        /**
+         * Remove the count readings starting at sequence first once they
+         * have been delivered. Readings of that range already dropped by
+         * Push or Clear are skipped, so readings queued behind them stay.
+         */
+        bool Pop(uint32_t first, uint32_t count);
+
+        /**
+         * Remove the oldest reading without delivering it, counted as
+         * dropped. Used for a reading that can't be read back.
+         */
+        bool Discard();
+        bool Clear();
+
+        uint32_t Count();
+        uint16_t Capacity() const { return _capacity; }
+        uint32_t Dropped() const { return _dropped; }
+
+        DropPolicy Policy() const { return _policy; }
+        void SetPolicy(DropPolicy policy) { _policy = policy; }
+
+    private:
+
+        uint16_t _capacity;
+        DropPolicy _policy;
+        uint32_t _dropped;
+
+#if defined (TARGET_MTS_MDOT_F411RE)
+        static char file[];
+        RecordLog _log;
+#else
+        sensor_reading _readings[MBED_CONF_APP_UPLINK_QUEUE_SIZE];
+        uint16_t _head;
+        uint16_t _count;
+        uint32_t _tail;
+#endif /* TARGET_MTS_MDOT_F411RE */
+};
+
+#endif
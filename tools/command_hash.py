@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+Generate the perfect hash dispatch table of the shell.
+
+Reads the command names from commands/command_list.h, searches for a seed
+that gives every name its own slot and writes commands/command_hash.h.
+The hash is FNV-1a over the name, starting from the seed, and the slot is
+its top bits, the low bits of FNV-1a mix poorly. It must match
+command_hash() in commands/commands.cpp.
+
+Usage:
+    command_hash.py [--list command_list.h] [--out command_hash.h]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_LIST = os.path.join(HERE, "..", "commands", "command_list.h")
+DEFAULT_OUT = os.path.join(HERE, "..", "commands", "command_hash.h")
+
+ENTRY = re.compile(r"^\s*SHELL_(?:COMMAND|SETTING)\(\s*(\w+)\s*,")
+
+FNV_PRIME = 16777619
+MAX_SEEDS = 1 << 20
+
+
+def load_names(path):
+    names = []
+    with open(path) as f:
+        for line in f:
+            match = ENTRY.match(line)
+            if match:
+                names.append(match.group(1))
+    return names
+
+
+def command_hash(name, seed):
+    h = seed
+    for c in name.encode():
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def slot(name, seed, bits):
+    return command_hash(name, seed) >> (32 - bits)
+
+
+def find_seed(names, bits):
+    for seed in range(1, MAX_SEEDS):
+        used = set()
+        for name in names:
+            slot_ = slot(name, seed, bits)
+            if slot_ in used:
+                break
+            used.add(slot_)
+        else:
+            return seed
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--list", default=DEFAULT_LIST)
+    parser.add_argument("--out", default=DEFAULT_OUT)
+    args = parser.parse_args()
+
+    names = load_names(args.list)
+    if len(set(names)) != len(names):
+        sys.exit("duplicate command names")
+
+    # a sparse table finds a seed quickly and costs a byte per slot
+    bits = 1
+    while (1 << bits) < 2 * len(names):
+        bits += 1
+
+    seed = find_seed(names, bits)
+    while seed is None:
+        bits += 1
+        seed = find_seed(names, bits)
+
+    slots = 1 << bits
+    table = [0] * slots
+    for index, name in enumerate(names):
+        table[slot(name, seed, bits)] = index + 1
+
+    with open(args.out, "w") as f:
+        f.write("// Generated by tools/command_hash.py from command_list.h, do not edit.\n")
+        f.write("// Slot i holds 1 + the index of the command hashing to i, 0 if none.\n\n")
+        f.write("#define COMMAND_HASH_SEED 0x%08xUL\n" % seed)
+        f.write("#define COMMAND_HASH_BITS %d\n" % bits)
+        f.write("#define COMMAND_HASH_SLOTS %d\n\n" % slots)
+        f.write("static const uint8_t command_slots[COMMAND_HASH_SLOTS] = {\n")
+        for i in range(0, slots, 16):
+            f.write("    " + ", ".join("%2d" % v for v in table[i:i + 16]) + ",\n")
+        f.write("};\n")
+
+    print("%d commands in %d slots, seed 0x%08x" % (len(names), slots, seed))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+Decode uplink payloads produced by UplinkBatch (uplink/uplink_batch.h).
+
+Usage:
+    payload_decoder.py [--format auto|fixed|lpp|series] HEX [HEX ...]
+
+With no HEX arguments, one payload per line is read from stdin. The auto
+format picks fixed (0x01) or series (0x02) from the first byte and treats
+anything else as CayenneLPP. Pass --format lpp for LPP frames whose first
+channel is 1 or 2.
+"""
+
+import argparse
+import struct
+import sys
+
+FIXED_FORMAT = 0x01
+SERIES_FORMAT = 0x02
+
+LPP_TYPES = {
+    0: ("digital_input", 1, False, 1),
+    1: ("digital_output", 1, False, 1),
+    2: ("analog_input", 2, True, 100),
+    3: ("analog_output", 2, True, 100),
+    101: ("luminosity", 2, False, 1),
+    102: ("presence", 1, False, 1),
+    103: ("temperature", 2, True, 10),
+    104: ("relative_humidity", 1, False, 2),
+    115: ("barometric_pressure", 2, False, 10),
+}
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def timed_reading(sensor, timestamp, value):
+    # the device clock counts from boot, timestamps carry the time epoch (a
+    # boot counter, modulo 256) in the top 8 bits and seconds into it below
+    return {"sensor": sensor, "timestamp": timestamp, "epoch": timestamp >> 24,
+            "seconds": timestamp & 0xFFFFFF, "value": value / 10.0}
+
+
+def decode_fixed(data):
+    if len(data) < 5 or data[0] != FIXED_FORMAT:
+        raise ValueError("not a fixed format frame")
+    first = struct.unpack(">I", data[1:5])[0]
+    readings = []
+    # a trailing partial reading is what the stack cut off, ignore it
+    for pos in range(5, len(data) - 4, 5):
+        sensor, offset, value = struct.unpack(">BHh", data[pos:pos + 5])
+        readings.append(timed_reading(sensor, first + offset, value))
+    return readings
+
+
+def decode_series(data):
+    if len(data) < 3 or data[0] != SERIES_FORMAT:
+        raise ValueError("not a time series frame")
+    sensor = data[1]
+    timestamp, pos = read_varint(data, 2)
+    value = 0
+    readings = []
+    while pos < len(data):
+        try:
+            dt, next_pos = read_varint(data, pos)
+            dv, next_pos = read_varint(data, next_pos)
+        except ValueError:
+            break
+        pos = next_pos
+        timestamp = (timestamp + unzigzag(dt)) & 0xFFFFFFFF
+        # the encoder takes differences modulo 2^32, wrap back to int32
+        value = ((value + unzigzag(dv) + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+        readings.append(timed_reading(sensor, timestamp, value))
+    return readings
+
+
+def decode_lpp(data):
+    readings = []
+    pos = 0
+    while pos + 2 <= len(data):
+        channel, kind = data[pos], data[pos + 1]
+        if kind not in LPP_TYPES:
+            raise ValueError("unknown LPP type %d" % kind)
+        name, size, signed, scale = LPP_TYPES[kind]
+        if pos + 2 + size > len(data):
+            break
+        raw = int.from_bytes(data[pos + 2:pos + 2 + size], "big", signed=signed)
+        readings.append({"sensor": channel, "type": name, "value": raw / scale if scale != 1 else raw})
+        pos += 2 + size
+    return readings
+
+
+def decode(data, fmt="auto"):
+    if fmt == "auto":
+        fmt = {FIXED_FORMAT: "fixed", SERIES_FORMAT: "series"}.get(data[0] if data else None, "lpp")
+    return {"fixed": decode_fixed, "lpp": decode_lpp, "series": decode_series}[fmt](data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--format", choices=["auto", "fixed", "lpp", "series"], default="auto")
+    parser.add_argument("payloads", nargs="*", help="payload as hex")
+    args = parser.parse_args()
+
+    payloads = args.payloads or [line.strip() for line in sys.stdin if line.strip()]
+    for payload in payloads:
+        for reading in decode(bytes.fromhex(payload.replace(" ", "")), args.format):
+            print(" ".join("%s=%s" % item for item in sorted(reading.items())))
+
+
+if __name__ == "__main__":
+    main()
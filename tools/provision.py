@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+Provision a device over the binary protocol of the provision command
+(provision/provisioning.h).
+
+The settings image is read from the device, or from a template saved with
+--dump, patched with the given EUIs and key and written back in a single
+request. The device stores it atomically.
+
+Usage:
+    provision.py --port DEV [--baud N] [--template FILE] [--deveui HEX]
+                 [--appeui HEX] [--appkey HEX] [--dump FILE] [--stay]
+
+Reset the device first, the tool enters command mode and starts the
+provision command itself. Needs pyserial.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+END = 0xC0
+ESC = 0xDB
+ESC_END = 0xDC
+ESC_ESC = 0xDD
+
+PING = 0x01
+READ = 0x02
+WRITE = 0x03
+EXIT = 0x04
+
+VERSION = 1
+PROTECTED_SIZE = 256
+SETTINGS_SIZE = 1024
+
+# offsets in the image, ProtectedSettings_t followed by NetworkSettings_t
+DEVICE_EUI = 1
+APP_EUI = (9, PROTECTED_SIZE + 13)
+APP_KEY = (17, PROTECTED_SIZE + 149)
+
+STATUS = {0: "ok", -1: "unknown command", -2: "bad length", -3: "save failed"}
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def slip_encode(frame):
+    out = bytearray([END])
+    for byte in frame:
+        if byte == END:
+            out += bytes([ESC, ESC_END])
+        elif byte == ESC:
+            out += bytes([ESC, ESC_ESC])
+        else:
+            out.append(byte)
+    out.append(END)
+    return bytes(out)
+
+
+class Device:
+    def __init__(self, port, baud):
+        import serial
+        self.serial = serial.Serial(port, baud, timeout=0.05)
+        self.sequence = 0
+        self.pending = bytearray()
+
+    def enter(self):
+        """Stop the boot countdown and start the provision command."""
+        self.serial.write(b"\r")
+        time.sleep(0.05)
+        self.serial.write(b"provision\r")
+        self.serial.flush()
+
+    def frames(self, deadline):
+        """Yield decoded frames until deadline, text between them is skipped."""
+        frame = None
+        escape = False
+        while time.monotonic() < deadline:
+            for byte in self.serial.read(self.serial.in_waiting or 1):
+                if byte == END:
+                    if frame:
+                        yield bytes(frame)
+                    frame = bytearray()
+                    escape = False
+                elif frame is None:
+                    continue
+                elif escape:
+                    frame.append(END if byte == ESC_END else ESC if byte == ESC_ESC else byte)
+                    escape = False
+                elif byte == ESC:
+                    escape = True
+                else:
+                    frame.append(byte)
+
+    def request(self, command, payload=b"", timeout=1.0, attempts=3):
+        """Send a request and return the response payload."""
+        for _ in range(attempts):
+            self.sequence = (self.sequence + 1) & 0xFF
+            frame = bytes([command, self.sequence]) + payload
+            self.serial.write(slip_encode(frame + struct.pack("<H", crc16(frame))))
+
+            for response in self.frames(time.monotonic() + timeout):
+                if len(response) < 5 or crc16(response[:-2]) != struct.unpack("<H", response[-2:])[0]:
+                    continue
+                if response[0] != command | 0x80 or response[1] != self.sequence:
+                    continue
+                status = struct.unpack("b", response[2:3])[0]
+                if status != 0:
+                    raise RuntimeError("command 0x%02x failed: %s" % (command, STATUS.get(status, status)))
+                return response[3:-2]
+        raise RuntimeError("no response to command 0x%02x" % command)
+
+
+def parse_hex(text, length, name):
+    value = bytes.fromhex(text)
+    if len(value) != length:
+        sys.exit("%s must be %d hex bytes" % (name, length))
+    return value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", required=True, help="serial port of the device")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--template", help="image to write instead of the one read from the device")
+    parser.add_argument("--deveui", help="device EUI, 8 hex bytes")
+    parser.add_argument("--appeui", help="application EUI, 8 hex bytes")
+    parser.add_argument("--appkey", help="application key, 16 hex bytes")
+    parser.add_argument("--dump", help="save the device's image to this file and exit")
+    parser.add_argument("--stay", action="store_true", help="leave the device in command mode")
+    args = parser.parse_args()
+
+    start = time.monotonic()
+    device = Device(args.port, args.baud)
+    device.enter()
+
+    info = device.request(PING, attempts=10, timeout=0.2)
+    version, protected_size, settings_size = struct.unpack("<BHH", info[:5])
+    if version != VERSION or protected_size != PROTECTED_SIZE or settings_size != SETTINGS_SIZE:
+        sys.exit("unsupported device: protocol %d, settings %d+%d bytes"
+                 % (version, protected_size, settings_size))
+
+    if args.template:
+        with open(args.template, "rb") as f:
+            image = bytearray(f.read())
+        if len(image) != PROTECTED_SIZE + SETTINGS_SIZE:
+            sys.exit("template must be %d bytes" % (PROTECTED_SIZE + SETTINGS_SIZE))
+    else:
+        image = bytearray(device.request(READ))
+
+    if args.dump:
+        with open(args.dump, "wb") as f:
+            f.write(image)
+    else:
+        if args.deveui:
+            image[DEVICE_EUI:DEVICE_EUI + 8] = parse_hex(args.deveui, 8, "deveui")
+        if args.appeui:
+            for offset in APP_EUI:
+                image[offset:offset + 8] = parse_hex(args.appeui, 8, "appeui")
+        if args.appkey:
+            for offset in APP_KEY:
+                image[offset:offset + 16] = parse_hex(args.appkey, 16, "appkey")
+        device.request(WRITE, bytes(image), timeout=3.0)
+
+    if not args.stay:
+        device.request(EXIT)
+        device.serial.write(b"run\r")
+
+    print("%s in %.0f ms" % ("dumped" if args.dump else "provisioned", (time.monotonic() - start) * 1000))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""
+Round trip tests of the uplink payload encoders (payload/payload_encoder.h)
+through payload_decoder.py.
+
+Usage:
+    test_payload.py [-v]
+
+Builds payload/test/payload_vectors.cpp with the host compiler (CXX, c++
+by default), runs it and decodes every vector it prints.
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import payload_decoder
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir)
+PAYLOAD = os.path.join(ROOT, "payload")
+
+
+def build_vectors():
+    out = tempfile.mkdtemp()
+    try:
+        exe = os.path.join(out, "payload_vectors")
+        subprocess.check_call([os.environ.get("CXX", "c++"), "-std=gnu++98", "-Wall", "-I", PAYLOAD,
+                               os.path.join(PAYLOAD, "payload_encoder.cpp"),
+                               os.path.join(PAYLOAD, "test", "payload_vectors.cpp"), "-o", exe])
+        run = subprocess.run([exe], stdout=subprocess.PIPE, universal_newlines=True)
+    finally:
+        shutil.rmtree(out)
+    return run.returncode, [line.split() for line in run.stdout.splitlines() if line.strip()]
+
+
+class PayloadRoundTrip(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.returncode, cls.vectors = build_vectors()
+
+    def of_kind(self, kind):
+        found = [vector[1:] for vector in self.vectors if vector[0] == kind]
+        self.assertTrue(found, "no %s vectors" % kind)
+        return found
+
+    def test_encoder_checks(self):
+        self.assertEqual(self.returncode, 0, "payload_vectors checks failed")
+
+    def test_varint(self):
+        for data, value in self.of_kind("varint"):
+            decoded, pos = payload_decoder.read_varint(bytes.fromhex(data), 0)
+            self.assertEqual(decoded, int(value))
+            self.assertEqual(pos, len(data) // 2)
+
+    def test_signed_varint(self):
+        for data, value in self.of_kind("svarint"):
+            decoded, pos = payload_decoder.read_varint(bytes.fromhex(data), 0)
+            self.assertEqual(payload_decoder.unzigzag(decoded), int(value))
+            self.assertEqual(pos, len(data) // 2)
+
+    def test_lpp(self):
+        scales = dict((kind, (name, scale)) for kind, (name, _, _, scale) in payload_decoder.LPP_TYPES.items())
+        for vector in self.of_kind("lpp"):
+            readings = payload_decoder.decode(bytes.fromhex(vector[0]), "lpp")
+            expected = [tuple(int(field) for field in entry.split(":")) for entry in vector[1:]]
+            self.assertEqual(len(readings), len(expected))
+            for reading, (channel, kind, raw) in zip(readings, expected):
+                name, scale = scales[kind]
+                self.assertEqual(reading["sensor"], channel)
+                self.assertEqual(reading["type"], name)
+                self.assertEqual(round(reading["value"] * scale), raw)
+
+    def test_series(self):
+        for vector in self.of_kind("series"):
+            data, sensor, base = bytes.fromhex(vector[0]), int(vector[1]), int(vector[2])
+            expected = [tuple(int(field) for field in entry.split(":")) for entry in vector[3:]]
+            self.assertEqual(payload_decoder.read_varint(data, 2)[0], base)
+            readings = payload_decoder.decode(data)
+            self.assertEqual(len(readings), len(expected))
+            for reading, (timestamp, value) in zip(readings, expected):
+                self.assertEqual(reading["sensor"], sensor)
+                self.assertEqual(reading["timestamp"], timestamp)
+                self.assertEqual(round(reading["value"] * 10), value)
+
+
+if __name__ == "__main__":
+    unittest.main()
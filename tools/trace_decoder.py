@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""
+Decode the console output of a device built with trace-deferred.
+
+Binary trace records (diag/deferred_trace.h) are turned back into text
+using the format table in diag/trace_formats.h, everything else is passed
+through unchanged.
+
+Usage:
+    trace_decoder.py [--formats trace_formats.h] [--port DEV [--baud N]] [FILE]
+    trace_decoder.py [--formats trace_formats.h] --table OUT.json
+
+Reads FILE, or stdin, or the serial port DEV (needs pyserial). --table
+writes the id to format string table as JSON instead of decoding.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+RECORD_MARKER = 0xA5
+MAX_ARGS = 4
+
+DEFAULT_FORMATS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                               "..", "diag", "trace_formats.h")
+
+FORMAT_LINE = re.compile(r'^\s*TRACE_FORMAT\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diuxXoc%])")
+
+
+def unescape(text):
+    return (text.replace("\\r", "\r").replace("\\n", "\n").replace("\\t", "\t")
+            .replace('\\"', '"').replace("\\\\", "\\"))
+
+
+def load_formats(path):
+    """Return the format strings in table order, the index is the id."""
+    formats = []
+    with open(path) as f:
+        for line in f:
+            match = FORMAT_LINE.match(line)
+            if match:
+                formats.append((match.group(1), unescape(match.group(2))))
+    return formats
+
+
+def render(fmt, args):
+    """Apply a C format to 32 bit words."""
+    values = iter(args)
+
+    def convert(match):
+        flags, kind = match.group(1), match.group(2)
+        if kind == "%":
+            return "%"
+        value = next(values, 0)
+        if kind in "di":
+            value = struct.unpack("<i", struct.pack("<I", value))[0]
+            kind = "d"
+        elif kind == "u":
+            kind = "d"
+        elif kind == "c":
+            value = chr(value & 0xFF)
+        return ("%" + flags + kind) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode_stream(data, formats, out):
+    """Decode bytes, returns the unconsumed tail (an incomplete record)."""
+    i = 0
+    text = bytearray()
+    while i < len(data):
+        if data[i] != RECORD_MARKER:
+            text.append(data[i])
+            i += 1
+            continue
+
+        if i + 4 > len(data):
+            break
+        count = data[i + 3]
+        length = 9 + 4 * count
+        if count > MAX_ARGS:
+            # not a record, a stray byte in the text
+            text.append(data[i])
+            i += 1
+            continue
+        if i + length > len(data):
+            break
+
+        record = data[i + 1:i + length]
+        check = 0
+        for b in record[:-1]:
+            check ^= b
+        if check != record[-1]:
+            text.append(data[i])
+            i += 1
+            continue
+
+        fmt_id, = struct.unpack_from("<H", record, 0)
+        timestamp, = struct.unpack_from("<I", record, 3)
+        args = struct.unpack_from("<%dI" % count, record, 7)
+
+        out.write(text.decode("ascii", "replace"))
+        text = bytearray()
+        if fmt_id < len(formats):
+            message = render(formats[fmt_id][1], args).strip()
+        else:
+            message = "unknown trace %d %s" % (fmt_id, " ".join("%08x" % a for a in args))
+        out.write("\n[%10.3f ms] %s\n" % (timestamp / 1000.0, message))
+        i += length
+
+    out.write(text.decode("ascii", "replace"))
+    out.flush()
+    return data[i:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--formats", default=DEFAULT_FORMATS, help="trace_formats.h of the firmware")
+    parser.add_argument("--table", help="write the string table as JSON and exit")
+    parser.add_argument("--port", help="serial port to read from")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("file", nargs="?", help="captured console output, stdin if omitted")
+    args = parser.parse_args()
+
+    formats = load_formats(args.formats)
+
+    if args.table:
+        with open(args.table, "w") as f:
+            json.dump([{"id": i, "name": name, "format": fmt} for i, (name, fmt) in enumerate(formats)], f, indent=2)
+        return 0
+
+    if args.port:
+        import serial
+        source = serial.Serial(args.port, args.baud, timeout=0.1)
+        read = lambda: source.read(256)
+    elif args.file:
+        source = open(args.file, "rb")
+        read = lambda: source.read(4096)
+    else:
+        source = sys.stdin.buffer
+        read = lambda: source.read1(4096) if hasattr(source, "read1") else source.read(4096)
+
+    pending = b""
+    try:
+        while True:
+            chunk = read()
+            if not chunk:
+                if args.port:
+                    continue
+                break
+            pending = decode_stream(pending + chunk, formats, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -19,21 +19,152 @@
  * If we have tracing library available, we can see traces from within the
  * stack. The library could be made unavailable by removing FEATURE_COMMON_PAL
  * from the mbed_app.json to save RAM.
+ *
+ * Trace lines of the stack and of the application go into a lock free ring
+ * that a low priority thread moves to the console, so no thread waits for
+ * another one's UART output.
  */
 
+#include <stdarg.h>
+
+#include "mbed.h"
 #include "mbed_trace.h"
+#include "trace_helper.h"
+#include "trace_ring.h"
+#include "deferred_trace.h"
+#include "console_tx.h"
+#include "memory_monitor.h"
+
+extern ConsoleTx console_tx;
+
+volatile uint8_t trace_level = MBED_CONF_APP_TRACE_LEVEL;
+
+static TraceRing trace_ring;
+
+/**
+ * Moves buffered traces to the console when nothing else runs
+ */
+static Thread trace_thread(osPriorityLow, MBED_CONF_APP_TRACE_STACK_SIZE, NULL, "trace");
+
+/**
+ * Set by the rings when a trace arrives while the thread has nothing left
+ */
+static EventFlags trace_flags;
+
+#define TRACE_FLAG_READY    0x01
+
+static void trace_ready()
+{
+    trace_flags.set(TRACE_FLAG_READY);
+}
+
+/**
+ * Sleeps until a trace is queued, polls only while the console is too
+ * full to take what is pending
+ */
+static void trace_flush_loop()
+{
+    while (true) {
+        bool pending;
+
+        trace_ring.Flush(console_tx);
+        pending = trace_ring.Pending();
+#if MBED_CONF_APP_TRACE_DEFERRED
+        deferred_trace.Flush();
+        pending = pending || deferred_trace.Pending() > 0;
+#endif
+
+        trace_flags.wait_any(TRACE_FLAG_READY, pending ? MBED_CONF_APP_TRACE_FLUSH_INTERVAL : osWaitForever);
+    }
+}
+
+static void start_trace_thread()
+{
+    trace_ring.Attach(trace_ready);
+#if MBED_CONF_APP_TRACE_DEFERRED
+    deferred_trace.Attach(trace_ready);
+#endif
+    trace_thread.start(trace_flush_loop);
+}
+
+/**
+ * Appends a line break and queues text, never blocks
+ */
+static void trace_line(const char* text, size_t length)
+{
+    char line[TraceRing::MaxLine];
+
+    if (length > sizeof(line) - 2) {
+        length = sizeof(line) - 2;
+    }
+    memcpy(line, text, length);
+    line[length++] = '\r';
+    line[length++] = '\n';
+    trace_ring.Write(line, length);
+}
+
+void app_tracef(uint8_t level, const char* format, ...)
+{
+    char line[TraceRing::MaxLine];
+    const char* prefix;
+    int length;
+    va_list ap;
+
+    switch (level) {
+        case TRACE_LEVEL_ERROR: prefix = "[ERR ] "; break;
+        case TRACE_LEVEL_WARN:  prefix = "[WARN] "; break;
+        case TRACE_LEVEL_INFO:  prefix = "[INFO] "; break;
+        default:                prefix = "[DBG ] "; break;
+    }
+
+    length = strlen(prefix);
+    memcpy(line, prefix, length);
+
+    va_start(ap, format);
+    int formatted = vsnprintf(line + length, sizeof(line) - length, format, ap);
+    va_end(ap);
+
+    if (formatted > 0) {
+        length += formatted;
+    }
+    if (length > (int) sizeof(line) - 1) {
+        length = sizeof(line) - 1;
+    }
+
+    trace_line(line, length);
+}
+
+void trace_level_set(uint8_t level)
+{
+    trace_level = level & TRACE_MASK_LEVEL;
+#ifdef FEA_TRACE_SUPPORT
+    mbed_trace_config_set((mbed_trace_config_get() & ~TRACE_MASK_LEVEL) | trace_level);
+#endif
+}
+
+uint32_t trace_dropped()
+{
+    return trace_ring.Dropped();
+}
 
 #ifdef FEA_TRACE_SUPPORT
 #include "platform/PlatformMutex.h"
 
 /**
- * Local mutex object for synchronization
+ * mbed_trace formats every line into one shared buffer, so formatting
+ * still has to be serialized. The lock is held for formatting only, the
+ * output is queued and written out by trace_thread.
  */
 static PlatformMutex mutex;
 
 static void serial_lock();
 static void serial_unlock();
 
+static void stack_trace_print(const char* text)
+{
+    trace_line(text, strlen(text));
+}
+
 /**
  * Sets up trace for the application
  * Wouldn't do anything if the FEATURE_COMMON_PAL is not added
@@ -45,6 +176,11 @@ void setup_trace()
     mbed_trace_mutex_wait_function_set(serial_lock);
     mbed_trace_mutex_release_function_set(serial_unlock);
     mbed_trace_init();
+    mbed_trace_print_function_set(stack_trace_print);
+    trace_level_set(trace_level);
+
+    memory_add_buffer("trace ring", sizeof(trace_ring));
+    start_trace_thread();
 }
 
 /**
@@ -65,8 +201,7 @@ static void serial_unlock()
 #else
 void setup_trace()
 {
-
+    memory_add_buffer("trace ring", sizeof(trace_ring));
+    start_trace_thread();
 }
 #endif
-
-
@@ -25,4 +25,35 @@
  */
 void setup_trace();
 
+#include <stdint.h>
+#include "mbed_trace.h"
+
+/**
+ * Active trace levels, a mask of TRACE_LEVEL_ERROR, _WARN, _INFO and _DEBUG.
+ * Checked before anything is formatted, a disabled level costs a branch.
+ */
+extern volatile uint8_t trace_level;
+
+/**
+ * Sets the levels of the application and of the stack traces
+ */
+void trace_level_set(uint8_t level);
+
+/**
+ * Trace lines dropped because the trace ring was full
+ */
+uint32_t trace_dropped();
+
+/**
+ * Formats a trace line and queues it without blocking, use the APP_ERROR,
+ * APP_WARN, APP_INFO and APP_DEBUG macros instead
+ */
+void app_tracef(uint8_t level, const char* format, ...);
+
+#define APP_TRACEF(level, ...)  do { if (trace_level & (level)) { app_tracef(level, __VA_ARGS__); } } while (0)
+#define APP_ERROR(...)          APP_TRACEF(TRACE_LEVEL_ERROR, __VA_ARGS__)
+#define APP_WARN(...)           APP_TRACEF(TRACE_LEVEL_WARN, __VA_ARGS__)
+#define APP_INFO(...)           APP_TRACEF(TRACE_LEVEL_INFO, __VA_ARGS__)
+#define APP_DEBUG(...)          APP_TRACEF(TRACE_LEVEL_DEBUG, __VA_ARGS__)
+
 #endif /* APP_TRACE_HELPER_H_ */
@@ -0,0 +1,174 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "mbed.h"
+#include "lora_region.h"
+
+// lora.phy is either a region name or its legacy index, these mirror the
+// values used by the stack so both forms can be compared in #if
+#define AS923   0x10
+#define AU915   0x11
+#define CN470   0x12
+#define CN779   0x13
+#define EU433   0x14
+#define EU868   0x15
+#define KR920   0x16
+#define IN865   0x17
+#define US915   0x18
+#define US915_HYBRID 0x19
+
+typedef struct {
+        uint32_t min_frequency;
+        uint32_t max_frequency;
+        uint16_t divisor;
+} duty_cycle_band;
+
+// spreading factor and bandwidth of the 125 kHz based datarates DR0-DR7,
+// DR7 is FSK at 50 kbps
+static const uint8_t eu_spreading_factor[16] = { 12, 11, 10, 9, 8, 7, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static const uint16_t eu_bandwidth[16] = { 125, 125, 125, 125, 125, 125, 250, 50, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+#if MBED_CONF_LORA_PHY == 8 || MBED_CONF_LORA_PHY == US915 || MBED_CONF_LORA_PHY == 9 || MBED_CONF_LORA_PHY == US915_HYBRID
+static const uint8_t max_payload[16] = { 11, 53, 125, 242, 242, 0, 0, 0, 53, 129, 242, 242, 242, 242, 0, 0 };
+static const uint8_t spreading_factor[16] = { 10, 9, 8, 7, 8, 0, 0, 0, 12, 11, 10, 9, 8, 7, 0, 0 };
+static const uint16_t bandwidth[16] = { 125, 125, 125, 125, 500, 0, 0, 0, 500, 500, 500, 500, 500, 500, 0, 0 };
+#define NO_DUTY_CYCLE
+#elif MBED_CONF_LORA_PHY == 2 || MBED_CONF_LORA_PHY == AU915
+static const uint8_t max_payload[16] = { 51, 51, 51, 115, 242, 242, 242, 0, 53, 129, 242, 242, 242, 242, 0, 0 };
+static const uint8_t spreading_factor[16] = { 12, 11, 10, 9, 8, 7, 8, 0, 12, 11, 10, 9, 8, 7, 0, 0 };
+static const uint16_t bandwidth[16] = { 125, 125, 125, 125, 125, 125, 500, 0, 500, 500, 500, 500, 500, 500, 0, 0 };
+#define NO_DUTY_CYCLE
+#elif MBED_CONF_LORA_PHY == 1 || MBED_CONF_LORA_PHY == AS923
+// uplink dwell time limited
+static const uint8_t max_payload[16] = { 0, 0, 11, 53, 125, 242, 242, 242, 0, 0, 0, 0, 0, 0, 0, 0 };
+#define spreading_factor eu_spreading_factor
+#define bandwidth eu_bandwidth
+static const duty_cycle_band bands[] = { { 915000000, 928000000, 100 } };
+#else
+// EU868, EU433, CN779, CN470, IN865 and KR920 share the same limits
+static const uint8_t max_payload[16] = { 51, 51, 51, 115, 222, 222, 222, 222, 0, 0, 0, 0, 0, 0, 0, 0 };
+#define spreading_factor eu_spreading_factor
+#define bandwidth eu_bandwidth
+#if MBED_CONF_LORA_PHY == 0 || MBED_CONF_LORA_PHY == EU868
+// ETSI EN 300 220 sub-bands g, g1, g2, g3 and g4
+static const duty_cycle_band bands[] = {
+    { 863000000, 868000000, 100 },
+    { 868000000, 868600000, 100 },
+    { 868700000, 869200000, 1000 },
+    { 869400000, 869650000, 10 },
+    { 869700000, 870000000, 100 }
+};
+#elif MBED_CONF_LORA_PHY == 5 || MBED_CONF_LORA_PHY == EU433
+static const duty_cycle_band bands[] = { { 433175000, 434665000, 100 } };
+#elif MBED_CONF_LORA_PHY == 4 || MBED_CONF_LORA_PHY == CN779
+static const duty_cycle_band bands[] = { { 779500000, 786500000, 100 } };
+#else
+#define NO_DUTY_CYCLE
+#endif
+#endif
+
+uint8_t region_max_payload(uint8_t datarate) {
+    if (datarate >= sizeof(max_payload)) {
+        return 0;
+    }
+
+    if (max_payload[datarate] > MBED_CONF_LORA_TX_MAX_SIZE) {
+        return MBED_CONF_LORA_TX_MAX_SIZE;
+    }
+    return max_payload[datarate];
+}
+
+uint8_t region_min_datarate() {
+    for (uint8_t datarate = 0; datarate < sizeof(max_payload); datarate++) {
+        if (max_payload[datarate] > 0) {
+            return datarate;
+        }
+    }
+    return 0;
+}
+
+bool region_datarate(uint8_t datarate, uint8_t& sf, uint16_t& bw_khz) {
+    if (datarate >= sizeof(max_payload) || bandwidth[datarate] == 0) {
+        return false;
+    }
+
+    sf = spreading_factor[datarate];
+    bw_khz = bandwidth[datarate];
+    return true;
+}
+
+int8_t region_band(uint32_t frequency, uint16_t& divisor) {
+#if !defined (NO_DUTY_CYCLE)
+    for (uint8_t i = 0; i < sizeof(bands) / sizeof(bands[0]) && i < REGION_MAX_BANDS; i++) {
+        if (frequency >= bands[i].min_frequency && frequency < bands[i].max_frequency) {
+            divisor = bands[i].divisor;
+            return i;
+        }
+    }
+#endif
+    divisor = 1;
+    return -1;
+}
+
+uint32_t region_channel_frequency(uint8_t channel) {
+#if MBED_CONF_LORA_PHY == 8 || MBED_CONF_LORA_PHY == US915 || MBED_CONF_LORA_PHY == 9 || MBED_CONF_LORA_PHY == US915_HYBRID
+    if (channel < 64) {
+        return 902300000 + channel * 200000UL;
+    } else if (channel < 72) {
+        return 903000000 + (channel - 64) * 1600000UL;
+    }
+#elif MBED_CONF_LORA_PHY == 2 || MBED_CONF_LORA_PHY == AU915
+    if (channel < 64) {
+        return 915200000 + channel * 200000UL;
+    } else if (channel < 72) {
+        return 915900000 + (channel - 64) * 1600000UL;
+    }
+#elif MBED_CONF_LORA_PHY == 3 || MBED_CONF_LORA_PHY == CN470
+    if (channel < 96) {
+        return 470300000 + channel * 200000UL;
+    }
+#else
+#if MBED_CONF_LORA_PHY == 1 || MBED_CONF_LORA_PHY == AS923
+    static const uint32_t default_channels[] = { 923200000, 923400000 };
+#elif MBED_CONF_LORA_PHY == 4 || MBED_CONF_LORA_PHY == CN779
+    static const uint32_t default_channels[] = { 779500000, 779700000, 779900000 };
+#elif MBED_CONF_LORA_PHY == 5 || MBED_CONF_LORA_PHY == EU433
+    static const uint32_t default_channels[] = { 433175000, 433375000, 433575000 };
+#elif MBED_CONF_LORA_PHY == 7 || MBED_CONF_LORA_PHY == KR920
+    static const uint32_t default_channels[] = { 922100000, 922300000, 922500000 };
+#elif MBED_CONF_LORA_PHY == 6 || MBED_CONF_LORA_PHY == IN865
+    static const uint32_t default_channels[] = { 865062500, 865402500, 865985000 };
+#else
+    static const uint32_t default_channels[] = { 868100000, 868300000, 868500000 };
+#endif
+    if (channel < sizeof(default_channels) / sizeof(default_channels[0])) {
+        return default_channels[channel];
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,70 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_LORA_REGION__
+#define __MTS_LORA_REGION__
+
+#include <stdint.h>
+
+/**
+ * Largest application payload (N in the LoRaWAN regional parameters) for a
+ * datarate of the region selected with lora.phy, capped to lora.tx-max-size.
+ * Returns 0 for datarates the region does not define.
+ */
+uint8_t region_max_payload(uint8_t datarate);
+
+/**
+ * Lowest datarate of the region that can carry a payload, the one the
+ * stack starts uplinks at with ADR.
+ */
+uint8_t region_min_datarate();
+
+/**
+ * Modulation of a datarate. spreading_factor is 0 for FSK, in which case
+ * bandwidth holds the bit rate in kbps. Returns false for datarates the
+ * region does not define.
+ */
+bool region_datarate(uint8_t datarate, uint8_t& spreading_factor, uint16_t& bandwidth_khz);
+
+/**
+ * Duty cycle sub-band of a frequency in Hz. Returns the band index and sets
+ * divisor to the inverse of the allowed duty cycle (100 for 1%), or returns
+ * -1 if the region does not restrict the frequency.
+ */
+int8_t region_band(uint32_t frequency, uint16_t& divisor);
+
+/**
+ * Frequency in Hz of one of the channels the region defines by default.
+ * Returns 0 for channels added by the network, whose frequency only the
+ * stack knows.
+ */
+uint32_t region_channel_frequency(uint8_t channel);
+
+#define REGION_MAX_BANDS    5
+
+#endif
@@ -0,0 +1,90 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "retry_policy.h"
+
+uint32_t RetryPolicy::_state = 0x2545F491;
+
+RetryPolicy::RetryPolicy()
+:   _min_delay(1000),
+    _max_delay(1000),
+    _delay(1000),
+    _attempts(0),
+    _jitter(0)
+{
+}
+
+void RetryPolicy::Seed(const uint8_t* eui, uint8_t length) {
+    // FNV-1a, spreads EUIs that differ in a single byte
+    uint32_t hash = 2166136261UL;
+
+    for (uint8_t i = 0; i < length; i++) {
+        hash ^= eui[i];
+        hash *= 16777619UL;
+    }
+
+    // xorshift never leaves the all zero state
+    _state = hash ? hash : 0x2545F491;
+}
+
+void RetryPolicy::Configure(uint32_t min_delay, uint32_t max_delay, uint8_t jitter) {
+    _min_delay = min_delay > 0 ? min_delay : 1;
+    _max_delay = max_delay > _min_delay ? max_delay : _min_delay;
+    _jitter = jitter > 100 ? 100 : jitter;
+    Reset();
+}
+
+uint32_t RetryPolicy::Next() {
+    uint32_t base = _delay;
+    uint32_t spread = (uint32_t) (((uint64_t) base * _jitter) / 100);
+
+    _attempts++;
+    _delay = (_delay > _max_delay / 2) ? _max_delay : _delay * 2;
+
+    if (spread == 0) {
+        return base;
+    }
+
+    return base - spread + Random() % (spread + 1);
+}
+
+void RetryPolicy::Reset() {
+    _delay = _min_delay;
+    _attempts = 0;
+}
+
+uint32_t RetryPolicy::Attempts() const {
+    return _attempts;
+}
+
+uint32_t RetryPolicy::Random() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
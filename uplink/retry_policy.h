@@ -0,0 +1,84 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_RETRY_POLICY__
+#define __MTS_RETRY_POLICY__
+
+#include "mbed.h"
+
+/**
+ * Exponential backoff with jitter for retrying joins and failed uplinks.
+ *
+ * Each call to Next doubles the base delay, starting at the minimum and
+ * capped at the maximum. jitter percent of the base delay is randomized so
+ * devices that failed at the same moment, e.g. when a gateway drops, do
+ * not retry in lockstep. The random generator is seeded from the DevEUI so
+ * every device follows its own sequence.
+ */
+class RetryPolicy {
+
+    public:
+
+        RetryPolicy();
+
+        /**
+         * Seed the random generator shared by all policies
+         */
+        static void Seed(const uint8_t* eui, uint8_t length);
+
+        void Configure(uint32_t min_delay, uint32_t max_delay, uint8_t jitter);
+
+        /**
+         * Delay in ms before the next attempt, advances the backoff
+         */
+        uint32_t Next();
+
+        /**
+         * Start over at the minimum delay after a success
+         */
+        void Reset();
+
+        /**
+         * Failed attempts since the last Reset
+         */
+        uint32_t Attempts() const;
+
+    private:
+
+        static uint32_t Random();
+
+        static uint32_t _state;
+
+        uint32_t _min_delay;
+        uint32_t _max_delay;
+        uint32_t _delay;
+        uint32_t _attempts;
+        uint8_t _jitter;
+};
+
+#endif
@@ -0,0 +1,143 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "tx_scheduler.h"
+
+// preamble symbols and the 4.25 symbols of sync word, in quarter symbols
+#define PREAMBLE_QUARTER_SYMBOLS    ((8 * 4) + 17)
+
+// FSK preamble, sync word, length and CRC bytes
+#define FSK_OVERHEAD                (5 + 3 + 1 + 2)
+
+TxScheduler::TxScheduler()
+{
+    Reset();
+}
+
+uint32_t TxScheduler::TimeOnAir(uint8_t datarate, uint16_t payload_length) {
+    uint8_t sf;
+    uint16_t bw;
+
+    if (!region_datarate(datarate, sf, bw)) {
+        return 0;
+    }
+
+    return TimeOnAir(sf, bw, payload_length + FrameOverhead);
+}
+
+uint32_t TxScheduler::TimeOnAir(uint8_t sf, uint16_t bw, uint16_t length) {
+    if (bw == 0) {
+        return 0;
+    }
+
+    if (sf == 0) {
+        // bits / kbps = ms
+        return ((length + FSK_OVERHEAD) * 8 + bw - 1) / bw;
+    }
+
+    // symbol time is exact in us for all LoRaWAN bandwidths
+    uint32_t symbol_us = ((uint32_t) 1 << sf) * 1000 / bw;
+
+    // coding rate 4/5, explicit header, CRC on, low datarate optimize
+    // for symbols longer than 16 ms
+    bool low_datarate = (sf >= 11 && bw == 125);
+    int32_t numerator = 8 * (int32_t) length - 4 * sf + 28 + 16;
+    int32_t denominator = 4 * (sf - (low_datarate ? 2 : 0));
+    uint32_t payload_symbols = 8;
+
+    if (numerator > 0) {
+        payload_symbols += ((numerator + denominator - 1) / denominator) * 5;
+    }
+
+    uint32_t toa_us = symbol_us * PREAMBLE_QUARTER_SYMBOLS / 4 + symbol_us * payload_symbols;
+    return (toa_us + 999) / 1000;
+}
+
+void TxScheduler::TxDone(uint8_t channel, uint32_t time_on_air) {
+    uint32_t frequency = region_channel_frequency(channel);
+    uint16_t divisor;
+    int8_t band;
+
+    if (frequency == 0) {
+        frequency = region_channel_frequency(0);
+    }
+
+    band = region_band(frequency, divisor);
+    if (band < 0 || divisor <= 1) {
+        return;
+    }
+
+    _band_free[band] = Kernel::get_ms_count() + (uint64_t) time_on_air * (divisor - 1);
+    _bands_used |= (1 << band);
+}
+
+void TxScheduler::Backoff(uint32_t delay) {
+    uint64_t until = Kernel::get_ms_count() + delay;
+
+    if (until > _backoff_until) {
+        _backoff_until = until;
+    }
+}
+
+void TxScheduler::Reset() {
+    for (uint8_t i = 0; i < REGION_MAX_BANDS; i++) {
+        _band_free[i] = 0;
+    }
+    _bands_used = 0;
+    _backoff_until = 0;
+}
+
+uint32_t TxScheduler::Delay() const {
+    uint64_t now = Kernel::get_ms_count();
+    uint64_t earliest = 0;
+    bool first = true;
+
+    // the stack picks whichever used band frees up first
+    for (uint8_t i = 0; i < REGION_MAX_BANDS; i++) {
+        if ((_bands_used & (1 << i)) && (first || _band_free[i] < earliest)) {
+            earliest = _band_free[i];
+            first = false;
+        }
+    }
+
+    if (_backoff_until > earliest) {
+        earliest = _backoff_until;
+    }
+
+    return earliest > now ? (uint32_t) (earliest - now) : 0;
+}
+
+uint32_t TxScheduler::BandDelay(uint8_t band) const {
+    uint64_t now = Kernel::get_ms_count();
+
+    if (band >= REGION_MAX_BANDS || !(_bands_used & (1 << band)) || _band_free[band] <= now) {
+        return 0;
+    }
+
+    return (uint32_t) (_band_free[band] - now);
+}
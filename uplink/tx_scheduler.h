@@ -0,0 +1,99 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_TX_SCHEDULER__
+#define __MTS_TX_SCHEDULER__
+
+#include "mbed.h"
+#include "lora_region.h"
+
+/**
+ * Keeps track of the duty cycle budget of each sub-band of the region and
+ * of the backoff reported by the stack, so the next uplink can be scheduled
+ * at the earliest instant the stack will accept it instead of retrying on
+ * a fixed timer.
+ *
+ * After a transmission of t ms on a band with a 1/divisor duty cycle the
+ * band is off for t * (divisor - 1) ms. Channels added by the network are
+ * charged to the band of the first default channel, which can only make
+ * the schedule more conservative than the stack.
+ */
+class TxScheduler {
+
+    public:
+
+        // MHDR, FHDR without options, FPort and MIC
+        static const uint8_t FrameOverhead = 13;
+
+        TxScheduler();
+
+        /**
+         * Time on air in ms of an uplink with payload_length application
+         * bytes at datarate, rounded up. Returns 0 for unknown datarates.
+         */
+        static uint32_t TimeOnAir(uint8_t datarate, uint16_t payload_length);
+
+        /**
+         * Time on air in ms of a LoRa frame of length PHY payload bytes,
+         * bandwidth_khz is the bit rate in kbps when spreading_factor is 0 (FSK).
+         */
+        static uint32_t TimeOnAir(uint8_t spreading_factor, uint16_t bandwidth_khz, uint16_t length);
+
+        /**
+         * Charge a completed transmission to the band of channel
+         */
+        void TxDone(uint8_t channel, uint32_t time_on_air);
+
+        /**
+         * No uplink will be accepted for delay ms, as reported by the stack
+         */
+        void Backoff(uint32_t delay);
+
+        /**
+         * Forget all budget, e.g. after a new join
+         */
+        void Reset();
+
+        /**
+         * ms until an uplink is allowed, 0 if it can be sent now
+         */
+        uint32_t Delay() const;
+
+        /**
+         * ms until band is available again, 0 if it is
+         */
+        uint32_t BandDelay(uint8_t band) const;
+
+    private:
+
+        uint64_t _band_free[REGION_MAX_BANDS];
+        uint8_t _bands_used;            // bit mask of bands charged so far
+        uint64_t _backoff_until;
+};
+
+#endif
@@ -0,0 +1,112 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#include "uplink_batch.h"
+#include "payload_encoder.h"
+
+UplinkBatch::UplinkBatch(UplinkQueue& queue)
+:   _queue(queue),
+    _readings(0)
+{
+}
+
+uint16_t UplinkBatch::Build(uint8_t* buffer, uint16_t max_length) {
+    PayloadWriter writer(buffer, max_length);
+    sensor_reading reading;
+
+    _readings = 0;
+
+    // a record torn by a reset fails to read back, skip it or it blocks the queue
+    while (_queue.Count() > 0 && !_queue.Peek(0, reading)) {
+        if (!_queue.Discard()) {
+            return 0;
+        }
+    }
+
+#if MBED_CONF_APP_PAYLOAD_FORMAT == 1
+    CayenneLPP lpp(writer);
+
+    while (_readings < MaxReadings && _queue.Peek(_readings, reading)
+            && lpp.AddTemperature(reading.Sensor, reading.Value)) {
+        _ends[_readings++] = writer.Length();
+    }
+#elif MBED_CONF_APP_PAYLOAD_FORMAT == 2
+    TimeSeriesEncoder series(writer);
+    uint8_t sensor = 0;
+
+    while (_readings < MaxReadings && _queue.Peek(_readings, reading)) {
+        if (_readings == 0) {
+            sensor = reading.Sensor;
+            if (!series.Begin(sensor, reading.Timestamp)) {
+                break;
+            }
+        } else if (reading.Sensor != sensor) {
+            // one sensor per frame
+            break;
+        }
+
+        if (!series.Add(reading.Timestamp, reading.Value)) {
+            break;
+        }
+        _ends[_readings++] = writer.Length();
+    }
+#else
+    uint32_t first = 0;
+
+    while (_readings < MaxReadings && _queue.Peek(_readings, reading)) {
+        if (_readings == 0) {
+            first = reading.Timestamp;
+            if (writer.Remaining() < 10 || !writer.PutByte(FixedFormat) || !writer.PutUint32(first)) {
+                break;
+            }
+        }
+
+        // readings further apart than the offset can express start a new frame
+        uint32_t offset = reading.Timestamp - first;
+        if (reading.Timestamp < first || offset > 0xFFFF || writer.Remaining() < 5) {
+            break;
+        }
+
+        writer.PutByte(reading.Sensor);
+        writer.PutUint16(offset);
+        writer.PutUint16(reading.Value);
+        _ends[_readings++] = writer.Length();
+    }
+#endif
+
+    return _readings ? writer.Length() : 0;
+}
+
+uint32_t UplinkBatch::Readings(uint16_t length) const {
+    uint32_t complete = 0;
+
+    while (complete < _readings && _ends[complete] <= length) {
+        complete++;
+    }
+    return complete;
+}
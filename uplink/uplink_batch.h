@@ -0,0 +1,90 @@
+/**********************************************************************
+* COPYRIGHT 2019 MULTI-TECH SYSTEMS, INC.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+*   3. Neither the name of MULTI-TECH SYSTEMS, INC. nor the names of its contributors
+*      may be used to endorse or promote products derived from this software
+*      without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+******************************************************************************
+*/
+
+#ifndef __MTS_UPLINK_BATCH__
+#define __MTS_UPLINK_BATCH__
+
+#include "mbed.h"
+#include "uplink_queue.h"
+
+/**
+ * Packs as many queued readings as fit into a single uplink, in the format
+ * selected with the payload-format configuration:
+ *
+ * 0: fixed layout, all fields big endian
+ *    0     format (0x01)
+ *    1-4   timestamp of the first reading
+ *    then per reading:
+ *    0     sensor
+ *    1-2   seconds since the first reading
+ *    3-4   value in tenths
+ *
+ * 1: CayenneLPP, one temperature entry per reading with the sensor as
+ *    channel, no timestamps
+ *
+ * 2: delta varint time series of one sensor, see TimeSeriesEncoder
+ *
+ * Timestamps are those of sensor_reading: the time epoch in the top 8 bits
+ * and the seconds since the epoch began in the low 24, as the device clock
+ * only counts from boot.
+ *
+ * tools/payload_decoder.py decodes all three formats.
+ */
+class UplinkBatch {
+
+    public:
+
+        static const uint8_t FixedFormat = 0x01;
+
+        UplinkBatch(UplinkQueue& queue);
+
+        /**
+         * Fill buffer with the oldest queued readings, never exceeding
+         * max_length. Returns the frame length, 0 if nothing is queued or
+         * not even one reading fits. Readings at the head of the queue that
+         * can't be read are discarded.
+         */
+        uint16_t Build(uint8_t* buffer, uint16_t max_length);
+
+        /**
+         * Number of readings of the last built frame that are complete
+         * within the first length bytes, as accepted by the stack.
+         */
+        uint32_t Readings(uint16_t length) const;
+
+    private:
+
+        // no format takes less than two bytes per reading
+        static const uint16_t MaxReadings = MBED_CONF_LORA_TX_MAX_SIZE / 2;
+
+        UplinkQueue& _queue;
+        uint32_t _readings;
+        uint8_t _ends[MaxReadings];     // frame length after each reading
+};
+
+#endif